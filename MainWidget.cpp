@@ -1,152 +1,63 @@
 #include "MainWidget.h"
 #include "aboutdialog.h"
+#include "configloader.h"
+#include "launchentry.h"
 #include "launcheritem.h"
+#include "launcherengine.h"
+#include "launcherhost.h"
+#include "launchgroups.h"
+#include "launchprocess.h"
 #include "ui_MainWidget.h"
 
 #include <QScreen>
 #include <QDir>
-#include <QFile>
-#include <QTextStream>
-#include <QJsonDocument>
+#include <QFileInfo>
 #include <QJsonObject>
-#include <QJsonArray>
 #include <QSystemTrayIcon>
 #include <QCloseEvent>
 #include <QMessageBox>
-#include <QStandardPaths>
-#include <QProcessEnvironment>
-#include <QRegularExpression>
 #include <QPlainTextEdit>
+#include <QDataStream>
 #include <QDialogButtonBox>
 #include <QDesktopWidget>
 #include <QMenu>
 #include <QStyle>
 #include <QFileDialog>
+#include <QPixmapCache>
+#include <QScrollArea>
+#include <QTabWidget>
+#include <QTemporaryFile>
+#include <QTextBrowser>
+#include <QThreadPool>
+#include <QTimer>
+#include <QImageReader>
 #include <qtlocalpeer.h>
 
 #include <flowlayout.h>
 
 #include <QtDebug>
 
-#ifdef Q_OS_WIN
-constexpr auto PATH_SEPARATOR = ';';
-#else
-constexpr auto PATH_SEPARATOR = ':';
+#ifdef __GLIBC__
+#include <malloc.h>
 #endif
-constexpr auto CONF_NAME = "launcher-conf.json";
-constexpr auto SHARE_DIR = "applauncher";
-constexpr auto RESOURCE_DIR = "resources";
 
-static QByteArray readEntireFile(const QString& path)
-{
-    QFile f(path);
-    if (f.open(QFile::ReadOnly))
-        return QTextStream{&f}.readAll().toUtf8();
-    qDebug() << "file error: " << path << "\n" << f.errorString();
-    return {};
-}
-
-static bool isAppImage()
-{
-#ifdef Q_OS_WIN
-    // In windows be linke as appImage
-    return true;
-#else
-    return qEnvironmentVariableIsSet("APPDIR");
-#endif
-}
-
-static QString pathJoin(const QStringList& parts)
-{
-    return parts.join(QDir::separator());
-}
-
-static QString appFile()
-{
-#ifdef Q_OS_LINUX
-    if (isAppImage())
-        return qgetenv("ARGV0");
-#endif
-    return QApplication::instance()->applicationFilePath();
-}
-
-static QString appPath()
-{
-    return QFileInfo(appFile()).absolutePath();
-}
-
-static QString sharePath()
-{
-    return pathJoin({ isAppImage()? appPath() : pathJoin({ appPath(), "..", "share" }), SHARE_DIR });
-}
-
-static QString resPath()
-{
-    return pathJoin({ sharePath(), RESOURCE_DIR });
-}
-
-static QString configurationFileName()
-{
-    return pathJoin({ sharePath(), CONF_NAME });
-}
-
-static QJsonObject loadConfig(const QString& configFile)
-{
-    QJsonParseError err;
-    auto doc = QJsonDocument::fromJson(readEntireFile(configFile), &err).object();
-    if (err.error != QJsonParseError::NoError) {
-        qDebug() << "Error loading " << configFile << ": " << err.errorString();
-        return {};
-    }
-    return doc;
-}
-
-static QSpacerItem *newSpacer()
-{
-    return new QSpacerItem(1, 1, QSizePolicy::Expanding, QSizePolicy::Expanding);
-}
+// time slice of the tile creation, so the window keeps painting
+constexpr auto ITEM_BATCH_MS = 8;
+// hidden for this long, the window releases its tiles and log
+constexpr auto TRIM_DELAY_MS = 5000;
 
-static void adjustInitialEnv()
+static void insertText(QTextBrowser *b, const QString& t, const QColor& color)
 {
-    auto homePath = QDir::home().absolutePath();
-    if (!qEnvironmentVariableIsSet("HOME")) {
-        auto homePaths = QStandardPaths::standardLocations(QStandardPaths::HomeLocation);
-        if (!homePaths.isEmpty())
-            homePath = homePaths.first();
-        qputenv("HOME", homePath.toLocal8Bit());
-    }
-    auto app = appFile().toLocal8Bit();
-    auto appDir = appPath().toLocal8Bit();
-    auto resDir = resPath().toLocal8Bit();
-
-    qputenv("APPLICATION_FILE_PATH", app);
-    qputenv("APPLICATION_DIR_PATH", appDir);
-    qputenv("APPLICATION_RESOURCE_PATH", resDir);
-    if (isAppImage())
-        qputenv("APPLICATION_REAL_FILE_PATH",
-                QApplication::instance()->applicationDirPath().toLocal8Bit());
-}
-
-static QString env(const QString& e)
-{
-    QString r;
-    auto env = QProcessEnvironment::systemEnvironment();
-    int i=0;
-    r.reserve(e.size());
-    while (i<e.size()) {
-        if (e[i] == QChar{'$'} && e[i+1] == QChar{'{'}) {
-            i+=2;
-            int idxEnd = e.indexOf('}', i);
-            QString var = e.mid(i, idxEnd - i);
-            QString val = env.value(var, QString{"${%1}"}.arg(var));
-            r.append(val);
-            i = idxEnd + 1;
-        } else {
-            r.append(e[i]);
-            i++;
-        }
-    }
-    return r;
+    auto c = b->textCursor();
+    c.movePosition(QTextCursor::End);
+    c.beginEditBlock();
+    QTextCharFormat fmt;
+    fmt.setForeground(color);
+    c.setCharFormat(fmt);
+    c.insertText(t);
+    c.endEditBlock();
+    b->setTextCursor(c);
+    b->ensureCursorVisible();
 }
 
 static QIcon loadIcon(const QString& name)
@@ -163,30 +74,67 @@ static QIcon loadIcon(const QString& name)
     return icon;
 }
 
-Widget::Widget(QWidget *parent)
+Widget::Widget(const QStringList &configFiles, const QElapsedTimer &started, QWidget *parent)
     : QWidget(parent),
-      ui(new Ui::Widget)
+      ui(new Ui::Widget),
+      toggleWindow(nullptr),
+      host(nullptr),
+      tabs(nullptr),
+      trayIcon(nullptr),
+      trayMenu(nullptr),
+      entriesEnd(nullptr),
+      terminateAction(nullptr),
+      iconPool(new QThreadPool{this}),
+      itemTimer(new QTimer{this}),
+      startup(started),
+      firstPaintMs(-1),
+      interactiveMs(-1),
+      trimTimer(new QTimer{this}),
+      trimmed(false),
+      logSpill(nullptr),
+      logTail(nullptr),
+      logOnDisk(false)
 {
-    auto configFile = configurationFileName();
-    if (!QFileInfo::exists(configFile))
-        configFile = QFileDialog::getOpenFileName(nullptr, tr("Select Configuration File"), QDir::homePath(), "*.json");
-
-    auto peer = new QtLocalPeer{this, configFile};
+    if (!startup.isValid())
+        startup.start();
+    // a single instance hosts every configuration
+    auto peer = new QtLocalPeer{this, LauncherEngine::configurationFile()};
     if (peer->isClient()) {
         setProperty("isClient", true);
-        qDebug() << "Another instance for" << configFile << "is running";
-        qDebug() << "<Maximize return:" << peer->sendMessage("maximize", 1000);
+        qDebug() << "Another instance is running";
+        if (configFiles.isEmpty()) {
+            bool headless = false;
+            qDebug() << "<Maximize return:" << peer->sendMessage("maximize", 1000, &headless);
+            setProperty("headlessOwner", headless);
+        }
+        for (const auto& f: configFiles)
+            qDebug() << "<Open" << f << "return:" << peer->sendMessage(LauncherHost::openMessage(f), 1000);
         return;
-    } else {
-        setProperty("isClient", false);
-        connect(peer, &QtLocalPeer::messageReceived, this, [this](const QString& msg) {
-            if (msg == "maximize") {
-                this->show();
-            }
-        });
     }
+    setProperty("isClient", false);
+
+    auto files = configFiles;
+    if (files.isEmpty()) {
+        auto configFile = LauncherEngine::configurationFile();
+        if (!QFileInfo::exists(configFile) && !QFileInfo::exists(ConfigLoader::fragmentDirectory(configFile)))
+            configFile = QFileDialog::getOpenFileName(nullptr, tr("Select Configuration File"), QDir::homePath(), "*.json");
+        files.append(configFile);
+    }
+
+    // the configurations are parsed while the window is set up
+    host = new LauncherHost{this};
+    host->preload(files);
+    host->serve(peer);
+    connect(peer, &QtLocalPeer::messageReceived, this, [this](const QString& msg) {
+        if (msg == "maximize") {
+            this->show();
+        }
+    });
+    connect(host, &LauncherHost::openRequested, this, [this](LauncherEngine *engine) {
+        tabs->setCurrentWidget(pages.value(engine));
+        show();
+    });
 
-    adjustInitialEnv();
     ui->setupUi(this);
     ui->logView->setFont(QFont{"Monospace, Consolas, Courier"});
     ui->logView->setContextMenuPolicy(Qt::CustomContextMenu);
@@ -194,7 +142,7 @@ Widget::Widget(QWidget *parent)
     logViewMenu->addAction(tr("Select All"), ui->logView, &QTextEdit::selectAll);
     logViewMenu->addAction(tr("Copy"), ui->logView, &QTextEdit::copy);
     logViewMenu->addSeparator();
-    logViewMenu->addAction(tr("Clear"), ui->logView, &QTextEdit::clear);
+    logViewMenu->addAction(tr("Clear"), this, &Widget::clearLog);
     connect(ui->logView, &QWidget::customContextMenuRequested, this, [this, logViewMenu](const QPoint& p) {
         logViewMenu->exec(ui->logView->mapToGlobal(p));
     });
@@ -203,103 +151,341 @@ Widget::Widget(QWidget *parent)
     ui->splitter->setSizes({ 120, 120 });
     connect(ui->buttonUpDown, &QToolButton::clicked, this, [this] () {
         auto t = ui->logView->isVisible();
+        if (!t)
+            restoreLog();
         ui->logView->setVisible(!t);
         ui->buttonUpDown->setArrowType(t? Qt::UpArrow : Qt::DownArrow);
     });
     ui->logView->hide();
     ui->buttonUpDown->setArrowType(Qt::UpArrow);
 
-    auto doc = loadConfig(configFile);
+    // one tab per configuration, the tab bar only shows with several
+    tabs = new QTabWidget{ui->layoutWidget};
+    tabs->setDocumentMode(true);
+    tabs->setTabBarAutoHide(true);
+    ui->verticalLayout_2->replaceWidget(ui->scrollArea, tabs);
 
-    if (doc.isEmpty()) {
-        QJsonParseError err;
-        doc = QJsonDocument::fromJson(readEntireFile(":/default-config.json"), &err).object();
-        if (err.error != QJsonParseError::NoError)
-            qDebug() << err.errorString();
-    }
-
-    QJsonObject initialSize = doc.value("initialSize").toObject();
-    resize(initialSize.value("width").toInt(width()), initialSize.value("height").toInt(height()));
-
-    auto resArray = doc.value("res").toArray();
-    for (const auto& a: qAsConst(resArray))
-        QDir::addSearchPath("res", env(a.toString()));
-
-    auto mainIcon = loadIcon(env(doc.value("mainIcon").toString()));
-    ui->mainIcon->setPixmap(mainIcon.pixmap(ui->mainIcon->size()));
-    auto mainLabel = env(doc.value("mainLabel").toString());
-    ui->mainLabel->setText(mainLabel);
-    setWindowTitle(mainLabel);
-
-    auto trayIcon = new QSystemTrayIcon(this);
-    trayIcon->setIcon(mainIcon);
-    auto menu = new QMenu(this);
+    trayIcon = new QSystemTrayIcon(this);
+    trayMenu = new QMenu(this);
     toggleWindow = new QAction(this);
     toggleWindow->setText(tr("Show Launcher"));
     connect(toggleWindow, &QAction::triggered, this, [this]() { setVisible(!isVisible()); });
-    menu->addAction(toggleWindow);
-    menu->addSeparator();
-
-    auto sysPath = QProcessEnvironment::systemEnvironment().value("PATH");
-    auto newPath = QStringList{};
-    auto pathArray = doc.value("path").toArray();
-    for (const auto& a: qAsConst(pathArray))
-        newPath.append(env(a.toString()));
-    newPath.append(sysPath);
-    if (!newPath.isEmpty()) {
-        auto pathStr = newPath.join(PATH_SEPARATOR);
-        qDebug() << pathStr << newPath;
-        qputenv("PATH", pathStr.toLocal8Bit());
-    }
-    auto envObj = doc.value("env").toObject();
-    for (auto it = envObj.constBegin(); it != envObj.constEnd(); ++it)
-        qputenv(it.key().toLocal8Bit().data(), env(it.value().toString()).toLocal8Bit());
-
-    int row = 0;
-    int col = 0;
-    auto layout = new QGridLayout{ui->scrollAreaWidgetContents};
-    auto appArray = doc.value("applications").toArray();
-    for(const auto& a: qAsConst(appArray)) {
-        auto o = a.toObject();
-        auto icon = loadIcon(env(o.value("icon").toString()));
-        auto text = env(o.value("text").toString());
-        auto exec = env(o.value("exec").toString());
-        auto work = env(o.value("work").toString());
-        auto procEnv = QProcessEnvironment::systemEnvironment();
-        if (o.contains("env")) {
-            auto procEnvObj = o.value("env").toObject();
-            for (auto it = procEnvObj .constBegin(); it != procEnvObj .constEnd(); ++it){
-                auto k = it.key();
-                auto v = env(it.value().toString());
-                qDebug() << "custom env" << k << v;
-                procEnv.insert(k, v);
-            }
-        }
-        auto launcher = new LauncherItem{icon, text, exec, work, procEnv, ui->logView, ui->scrollAreaWidgetContents};
-        auto action = menu->addAction(icon, text, launcher, &LauncherItem::startStop);
-        action->setCheckable(true);
-        connect(launcher, &LauncherItem::stateChange, action, &QAction::setChecked);
-        layout->addWidget(launcher, row, col);
-        if (++col == 3)
-            { col = 0; row++; }
-    }
-    if (col==1 || col==2)
-        layout->addItem(newSpacer(), row, col, 1, 3-col);
-    layout->setRowStretch(row + 1, 1);
-    ui->scrollAreaWidgetContents->setLayout(layout);
+    trayMenu->addAction(toggleWindow);
+    trayMenu->addSeparator();
+    // the first configuration fills the tray menu itself, before entriesEnd
+    entriesEnd = trayMenu->addSeparator();
+    terminateAction = trayMenu->addAction(tr("Terminate Launcher"), QApplication::instance(), &QApplication::quit);
 
     connect(ui->buttonShutdown, &QToolButton::clicked,
             QApplication::instance(), &QApplication::quit);
     connect(ui->buttonHelp, &QToolButton::clicked, this, [this]() {
         AboutDialog(size() * 0.9, this).exec();
     });
-    if (col + row > 0)
-        menu->addSeparator();
-
-    menu->addAction(tr("Terminate Launcher"), QApplication::instance(), &QApplication::quit);
-    trayIcon->setContextMenu(menu);
+    trayIcon->setContextMenu(trayMenu);
     connect(trayIcon, &QSystemTrayIcon::activated, this, &QWidget::show);
+
+    connect(itemTimer, &QTimer::timeout, this, &Widget::addPendingItems);
+    trimTimer->setSingleShot(true);
+    trimTimer->setInterval(TRIM_DELAY_MS);
+    connect(trimTimer, &QTimer::timeout, this, &Widget::trim);
+    connect(host, &LauncherHost::opened, this, &Widget::addConfiguration);
+    for (const auto& f: qAsConst(files))
+        host->open(f);
     trayIcon->show();
+    qDebug() << "startup: window set up after" << startup.elapsed() << "ms";
+}
+
+// Decodes the raster images of names on the icon pool, for icon() to pick
+// up; theme and SVG icons are cheap to create and rendered on demand
+void Widget::decodeIcons(const QStringList &names)
+{
+    for (const auto& name: names) {
+        if (name.isEmpty() || name.startsWith("theme:") || icons.contains(name) || decoding.contains(name))
+            continue;
+        auto suffix = QFileInfo{name}.suffix().toLower();
+        if (suffix == "svg" || suffix == "svgz")
+            continue;
+        auto images = std::make_shared<std::promise<QList<QImage>>>();
+        decoding.insert(name, images->get_future().share());
+        iconPool->start([images, name]() {
+            // every image of the file, as QIcon would load them
+            QList<QImage> r;
+            QImageReader reader{name};
+            QImage image;
+            while (reader.read(&image)) {
+                r.append(image);
+                if (!reader.jumpToNextImage())
+                    break;
+            }
+            images->set_value(r);
+        });
+    }
+}
+
+QIcon Widget::icon(const QString &name)
+{
+    auto it = icons.constFind(name);
+    if (it != icons.constEnd())
+        return *it;
+    QIcon icon;
+    auto images = decoding.take(name);
+    if (images.valid())
+        for (const auto& image: images.get())
+            icon.addPixmap(QPixmap::fromImage(image));
+    if (icon.isNull())
+        icon = loadIcon(name);
+    return *icons.insert(name, icon);
+}
+
+void Widget::addConfiguration(LauncherEngine *engine)
+{
+    auto doc = engine->configuration();
+    auto mainLabel = engine->expand(doc.value("mainLabel").toString());
+    const auto entries = engine->entries();
+    QStringList iconNames;
+    for (auto entry: entries)
+        iconNames.append(entry->iconName());
+    decodeIcons(iconNames);
+
+    auto area = ui->scrollArea;
+    auto contents = ui->scrollAreaWidgetContents;
+    auto menu = trayMenu;
+    QAction *before = entriesEnd;
+    bool first = pages.isEmpty();
+    if (first) {
+        QJsonObject initialSize = doc.value("initialSize").toObject();
+        resize(initialSize.value("width").toInt(width()), initialSize.value("height").toInt(height()));
+
+        auto mainIcon = icon(engine->resource(engine->expand(doc.value("mainIcon").toString())));
+        ui->mainIcon->setPixmap(mainIcon.pixmap(ui->mainIcon->size()));
+        ui->mainLabel->setText(mainLabel);
+        setWindowTitle(mainLabel);
+        trayIcon->setIcon(mainIcon);
+    } else {
+        area = new QScrollArea{tabs};
+        area->setFrameShape(QFrame::NoFrame);
+        area->setWidgetResizable(true);
+        contents = new QWidget{area};
+        area->setWidget(contents);
+        // further configurations get a tray submenu of their own
+        menu = new QMenu{mainLabel.isEmpty()? engine->prefix() : mainLabel, trayMenu};
+        before = nullptr;
+    }
+    tabs->addTab(area, mainLabel.isEmpty()? engine->prefix() : mainLabel);
+    pages.insert(engine, area);
+
+    const auto errors = engine->loadErrors();
+    for (const auto& e: errors)
+        appendLog(e.toLocal8Bit() + '\n', true);
+    if (!errors.isEmpty())
+        trayIcon->showMessage(tr("Configuration errors"), errors.join('\n'), QSystemTrayIcon::Warning);
+    connect(this, &Widget::visibilityChanged, engine, &LauncherEngine::setFrontEndVisible);
+
+    // the tray actions are cheap: created now, their icons and the tiles
+    // follow from addPendingItems()
+    auto pauseMenu = new QMenu{tr("Pause"), menu};
+    // as many columns as the width allows
+    auto layout = new FlowLayout{contents};
+    tileCounts.insert(layout, 0);
+    for (auto entry: entries) {
+        auto text = entry->text();
+        if (entry->hasReadinessProbe()) {
+            connect(entry, &LaunchEntry::readyChanged, trayIcon, [this, text](bool ready) {
+                if (ready)
+                    trayIcon->showMessage(text, tr("%1 is ready").arg(text));
+            });
+        }
+        connect(entry, &LaunchEntry::probeFailed, trayIcon, [this, text](const QString& pattern) {
+            trayIcon->showMessage(text, tr("%1 failed: %2").arg(text, pattern), QSystemTrayIcon::Warning);
+        });
+        connect(entry, &LaunchEntry::outputReceived, this, &Widget::appendLog);
+        auto action = new QAction{text, menu};
+        connect(action, &QAction::triggered, entry, &LaunchEntry::startStop);
+        menu->insertAction(before, action);
+        action->setCheckable(true);
+        action->setEnabled(entry->isAvailable());
+        // may already run, reattached by the engine
+        action->setChecked(entry->state() == QProcess::Running);
+        connect(entry, &LaunchEntry::stateChange, action, &QAction::setChecked);
+        connect(entry, &LaunchEntry::availableChanged, action, &QAction::setEnabled);
+        auto pauseAction = pauseMenu->addAction(text, entry, &LaunchEntry::setFrozen);
+        pauseAction->setCheckable(true);
+        pauseAction->setEnabled(entry->state() == QProcess::Running);
+        connect(entry, &LaunchEntry::stateChange, pauseAction, &QAction::setEnabled);
+        connect(entry, &LaunchEntry::frozenChanged, pauseAction, &QAction::setChecked);
+        tiles.append({ entry, contents, layout, action, pauseAction });
+        pendingItems.enqueue(tiles.last());
+    }
+    contents->setLayout(layout);
+
+    auto launchGroups = engine->groups();
+    auto groupNames = launchGroups->groups();
+    if (!pauseMenu->isEmpty() || !groupNames.isEmpty())
+        menu->insertSeparator(before);
+    if (!pauseMenu->isEmpty())
+        menu->insertMenu(before, pauseMenu);
+    if (!groupNames.isEmpty()) {
+        auto groupMenu = new QMenu{tr("Start Group"), menu};
+        for (const auto& g: qAsConst(groupNames))
+            groupMenu->addAction(g, launchGroups, [launchGroups, g]() { launchGroups->startGroup(g); });
+        menu->insertMenu(before, groupMenu);
+    }
+    if (!first)
+        trayMenu->insertMenu(terminateAction, menu);
+    itemTimer->start();
+}
+
+// Creates the pending tiles for ITEM_BATCH_MS at most, then lets the event
+// loop paint them before the next batch
+void Widget::addPendingItems()
+{
+    QElapsedTimer batch;
+    batch.start();
+    while (!pendingItems.isEmpty() && batch.elapsed() < ITEM_BATCH_MS) {
+        auto p = pendingItems.dequeue();
+        auto entryIcon = icon(p.entry->iconName());
+        p.action->setIcon(entryIcon);
+        p.pauseAction->setIcon(entryIcon);
+        p.layout->addWidget(new LauncherItem{p.entry, entryIcon, p.contents});
+        tileCounts[p.layout]++;
+    }
+    if (!pendingItems.isEmpty())
+        return;
+    itemTimer->stop();
+    if (reshow.isValid()) {
+        qDebug() << "re-shown" << tiles.size() << "items in" << reshow.elapsed() << "ms, rss"
+                 << LaunchProcess::residentKiB() << "KiB";
+        reshow.invalidate();
+    }
+    if (interactiveMs < 0) {
+        interactiveMs = startup.elapsed();
+        reportStartup();
+    }
+}
+
+// Once the window painted and every tile exists
+void Widget::reportStartup()
+{
+    if (firstPaintMs < 0 || interactiveMs < 0)
+        return;
+    int items = 0;
+    for (auto tiles: qAsConst(tileCounts))
+        items += tiles;
+    qDebug() << "startup: first paint after" << firstPaintMs << "ms, interactive after"
+             << interactiveMs << "ms with" << items << "items";
+}
+
+void Widget::appendLog(const QByteArray &data, bool isError)
+{
+    // once the log is on disk the output follows it there, in order,
+    // until restoreLog() replays it
+    if (!logOnDisk && !(trimmed && ui->logView->document()->isEmpty())) {
+        insertText(ui->logView, data, isError? Qt::darkRed : Qt::darkBlue);
+        return;
+    }
+    if (!logTail) {
+        logTail = new QTemporaryFile{this};
+        if (!logTail->open())
+            qWarning() << "cannot spill the log:" << logTail->errorString();
+    }
+    if (!logTail->isOpen()) {
+        insertText(ui->logView, data, isError? Qt::darkRed : Qt::darkBlue);
+        return;
+    }
+    logTail->seek(logTail->size());
+    QDataStream s{logTail};
+    s << isError << data;
+    logOnDisk = true;
+}
+
+void Widget::clearLog()
+{
+    ui->logView->clear();
+    if (logSpill)
+        logSpill->resize(0);
+    if (logTail)
+        logTail->resize(0);
+    logOnDisk = false;
+}
+
+// Writes the log document to a temporary file and empties it: after a long
+// session its blocks and layout are most of the window memory
+void Widget::spillLog()
+{
+    if (ui->logView->document()->isEmpty())
+        return;
+    if (!logSpill) {
+        logSpill = new QTemporaryFile{this};
+        if (!logSpill->open()) {
+            qWarning() << "cannot spill the log:" << logSpill->errorString();
+            delete logSpill;
+            logSpill = nullptr;
+            return;
+        }
+    }
+    // the document left by restoreLog() replaces the one on disk
+    logSpill->resize(0);
+    logSpill->seek(0);
+    logSpill->write(ui->logView->toHtml().toUtf8());
+    logSpill->flush();
+    if (logTail)
+        logTail->resize(0);
+    ui->logView->clear();
+    logOnDisk = true;
+}
+
+// Brings the spilled log back, with the output received since, when the
+// log view is about to show
+void Widget::restoreLog()
+{
+    if (!logOnDisk)
+        return;
+    logOnDisk = false;
+    if (logSpill && logSpill->size() > 0) {
+        logSpill->seek(0);
+        ui->logView->setHtml(QString::fromUtf8(logSpill->readAll()));
+        logSpill->resize(0);
+    }
+    if (logTail && logTail->size() > 0) {
+        logTail->seek(0);
+        QDataStream s{logTail};
+        while (!s.atEnd()) {
+            bool isError = false;
+            QByteArray data;
+            s >> isError >> data;
+            if (s.status() != QDataStream::Ok)
+                break;
+            insertText(ui->logView, data, isError? Qt::darkRed : Qt::darkBlue);
+        }
+        logTail->resize(0);
+    }
+}
+
+// Enters the trimmed state: the tiles are deleted (showEvent() streams
+// them in again from tiles), the rendered icon pixmaps and the log leave
+// memory and the freed heap goes back to the system. The tray menu keeps
+// its icons, shared with the icons cache.
+void Widget::trim()
+{
+    if (trimmed || isVisible())
+        return;
+    auto rss = LaunchProcess::residentKiB();
+    itemTimer->stop();
+    pendingItems.clear();
+    for (auto it = tileCounts.begin(); it != tileCounts.end(); ++it) {
+        while (auto item = it.key()->takeAt(0)) {
+            delete item->widget();
+            delete item;
+        }
+        it.value() = 0;
+    }
+    spillLog();
+    trimmed = true;
+    QPixmapCache::clear();
+#ifdef __GLIBC__
+    ::malloc_trim(0);
+#endif
+    qDebug() << "trimmed" << tiles.size() << "items, rss" << rss << "->" << LaunchProcess::residentKiB() << "KiB";
 }
 
 Widget::~Widget()
@@ -317,6 +503,17 @@ void Widget::showEvent(QShowEvent *event)
 {
     Q_UNUSED(event)
     toggleWindow->setText(tr("Hide Launcher"));
+    emit visibilityChanged(true);
+    trimTimer->stop();
+    if (trimmed) {
+        trimmed = false;
+        reshow.start();
+        if (ui->logView->isVisibleTo(this))
+            restoreLog();
+        for (const auto& t: qAsConst(tiles))
+            pendingItems.enqueue(t);
+        itemTimer->start();
+    }
     setGeometry(
         QStyle::alignedRect(
             Qt::LeftToRight,
@@ -326,8 +523,19 @@ void Widget::showEvent(QShowEvent *event)
         );
 }
 
+void Widget::paintEvent(QPaintEvent *event)
+{
+    if (firstPaintMs < 0) {
+        firstPaintMs = startup.elapsed();
+        reportStartup();
+    }
+    QWidget::paintEvent(event);
+}
+
 void Widget::hideEvent(QHideEvent *event)
 {
     Q_UNUSED(event);
     toggleWindow->setText(tr("Show Launcher"));
+    emit visibilityChanged(false);
+    trimTimer->start();
 }
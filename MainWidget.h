@@ -2,29 +2,101 @@
 #define MAINWIDGET_H
 
 #include <QWidget>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QIcon>
+#include <QImage>
+#include <QQueue>
+
+#include <future>
 
 namespace Ui {
 class Widget;
 }
 
+class QMenu;
 class QSystemTrayIcon;
+class QTabWidget;
+class QTemporaryFile;
+class QThreadPool;
+class QTimer;
+class FlowLayout;
+class LaunchEntry;
+class LauncherEngine;
+class LauncherHost;
 
 class Widget : public QWidget
 {
     Q_OBJECT
 
 public:
-    explicit Widget(QWidget *parent = nullptr);
+    // Opens configFiles, or the default configuration without any. The
+    // startup times are reported from started, when given
+    explicit Widget(const QStringList& configFiles = {},
+                    const QElapsedTimer& started = {},
+                    QWidget *parent = nullptr);
     ~Widget() override;
 
+signals:
+    void visibilityChanged(bool visible);
+
 protected:
     void closeEvent(QCloseEvent *event) override;
     void showEvent(QShowEvent *event) override;
     void hideEvent(QHideEvent *event) override;
+    void paintEvent(QPaintEvent *event) override;
 
 private:
+    // A tile of the window, with the tray actions of its entry
+    struct PendingItem {
+        LaunchEntry *entry;
+        QWidget *contents;
+        FlowLayout *layout;
+        QAction *action;
+        QAction *pauseAction;
+    };
+
+    void addConfiguration(LauncherEngine *engine);
+    void addPendingItems();
+    void reportStartup();
+    void appendLog(const QByteArray& data, bool isError);
+    void clearLog();
+    void spillLog();
+    void restoreLog();
+    void trim();
+    void decodeIcons(const QStringList& names);
+    QIcon icon(const QString& name);
+
     Ui::Widget *ui;
     QAction *toggleWindow;
+    LauncherHost *host;
+    QTabWidget *tabs;
+    QSystemTrayIcon *trayIcon;
+    QMenu *trayMenu;
+    QAction *entriesEnd;
+    QAction *terminateAction;
+    QHash<LauncherEngine *, QWidget *> pages;
+    // shared by all the configurations and matrix instances
+    QHash<QString, QIcon> icons;
+    // raster icons being decoded on iconPool
+    QThreadPool *iconPool;
+    QHash<QString, std::shared_future<QList<QImage>>> decoding;
+    // tiles are created a few at a time once the window shows
+    QList<PendingItem> tiles;
+    QQueue<PendingItem> pendingItems;
+    QHash<FlowLayout *, int> tileCounts;
+    QTimer *itemTimer;
+    QElapsedTimer startup;
+    qint64 firstPaintMs;
+    qint64 interactiveMs;
+    // while hidden for a while the tiles are released and the log waits
+    // on disk: logSpill holds the document, logTail the output since
+    QTimer *trimTimer;
+    bool trimmed;
+    QTemporaryFile *logSpill;
+    QTemporaryFile *logTail;
+    bool logOnDisk;
+    QElapsedTimer reshow;
 };
 
 #endif // MAINWIDGET_H
@@ -0,0 +1,6 @@
+# Benchmarks, built apart from the application:
+#
+#     qmake bench/bench.pro && make && peerbench/peerbench
+
+TEMPLATE = subdirs
+SUBDIRS = peerbench
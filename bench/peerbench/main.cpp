@@ -0,0 +1,219 @@
+// Round trip latency and throughput of QtLocalPeer: this process runs the
+// server, and for every message size starts the client processes, which
+// all send their messages at the same time, one after the other each.
+//
+//     peerbench [--clients N] [--messages M] [--sizes 64,4096,...] [--direct]
+//
+// --direct sends with sendMessageDirect() instead of sendMessage(). One
+// JSON line is printed per size; the exit code is 1 when a message was
+// lost.
+
+#include <qtlocalpeer.h>
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QProcess>
+#include <QTimer>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <limits>
+#include <vector>
+
+constexpr auto SEND_TIMEOUT = 5000;
+// How often the server's event loop is expected to run
+constexpr auto HEARTBEAT_MS = 5;
+// Under the peer's own message limit
+constexpr auto MAX_MESSAGE_SIZE = 1000 * 1000;
+
+static qint64 monotonicNsecs()
+{
+    // the same clock in every process
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Client process: prints its first and last send time, then the latency
+// of each message, in nanoseconds, one per line
+static int runClient(const QString &appId, int messages, int size, bool direct)
+{
+    QtLocalPeer peer{nullptr, appId};
+    auto message = QString{size, QLatin1Char('x')};
+    std::vector<qint64> latencies;
+    latencies.reserve(size_t(messages));
+    auto start = monotonicNsecs();
+    for (int i = 0; i < messages; i++) {
+        QElapsedTimer t;
+        t.start();
+        bool ok = direct? QtLocalPeer::sendMessageDirect(appId, message, SEND_TIMEOUT)
+                        : peer.sendMessage(message, SEND_TIMEOUT);
+        if (!ok)
+            break;
+        latencies.push_back(t.nsecsElapsed());
+    }
+    auto end = monotonicNsecs();
+    std::printf("%lld %lld\n", static_cast<long long>(start), static_cast<long long>(end));
+    for (auto l: latencies)
+        std::printf("%lld\n", static_cast<long long>(l));
+    return latencies.size() == size_t(messages)? 0 : 1;
+}
+
+class Bench : public QObject
+{
+public:
+    Bench(const QString &appId, int clients, int messages, const QList<int> &sizes, bool direct)
+        : appId{appId}, clients{clients}, messages{messages}, sizes{sizes}, direct{direct},
+          peer{new QtLocalPeer{this, appId}}
+    {
+        connect(peer, &QtLocalPeer::messageReceived, this, [this](const QString &m) {
+            received++;
+            receivedBytes += m.size();
+        });
+        // the longest the event loop went without running: a blocking
+        // server shows up here long before it shows in the latencies
+        heartbeat.setInterval(HEARTBEAT_MS);
+        connect(&heartbeat, &QTimer::timeout, this, [this]() {
+            maxStall = qMax(maxStall, sinceBeat.restart());
+        });
+    }
+
+    bool listen() { return !peer->isClient(); }
+
+    void next()
+    {
+        if (sizes.isEmpty()) {
+            QCoreApplication::exit(lost? 1 : 0);
+            return;
+        }
+        size = sizes.takeFirst();
+        received = receivedBytes = 0;
+        output.clear();
+        maxStall = 0;
+        sinceBeat.start();
+        heartbeat.start();
+        running = clients;
+        for (int i = 0; i < clients; i++) {
+            auto p = new QProcess{this};
+            p->setProcessChannelMode(QProcess::ForwardedErrorChannel);
+            connect(p, &QProcess::readyReadStandardOutput, this, [this, p]() {
+                output[p].append(p->readAllStandardOutput());
+            });
+            connect(p, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished), this, [this, p]() {
+                output[p].append(p->readAllStandardOutput());
+                if (--running == 0)
+                    report();
+            });
+            QStringList args{"--client", appId, QString::number(messages), QString::number(size)};
+            if (direct)
+                args << "--direct";
+            p->start(QCoreApplication::applicationFilePath(), args);
+        }
+    }
+
+private:
+    void report()
+    {
+        heartbeat.stop();
+        std::vector<qint64> all;
+        qint64 first = std::numeric_limits<qint64>::max();
+        qint64 last = 0;
+        for (auto it = output.begin(); it != output.end(); ++it) {
+            const auto lines = it.value().split('\n');
+            const auto span = lines.value(0).split(' ');
+            if (span.size() == 2) {
+                first = qMin(first, span.at(0).toLongLong());
+                last = qMax(last, span.at(1).toLongLong());
+            }
+            for (int i = 1; i < lines.size(); i++)
+                if (!lines.at(i).isEmpty())
+                    all.push_back(lines.at(i).toLongLong());
+            it.key()->deleteLater();
+        }
+        auto expected = qint64(clients) * messages;
+        lost = lost || qint64(all.size()) != expected || received != expected;
+        if (all.empty()) {
+            std::fprintf(stderr, "size %d: no message went through\n", size);
+            QCoreApplication::exit(2);
+            return;
+        }
+        std::sort(all.begin(), all.end());
+        auto percentile = [&all](size_t p) {
+            return all.at(qMin(all.size() - 1, all.size() * p / 100)) / 1000.0;
+        };
+        double seconds = qMax<qint64>(last - first, 1) / 1e9;
+        QJsonObject line{
+            {"clients", clients},
+            {"messages", qint64(all.size())},
+            {"bytes", size},
+            {"mode", direct? "direct" : "socket"},
+            {"p50us", percentile(50)},
+            {"p99us", percentile(99)},
+            {"messagesPerSecond", all.size() / seconds},
+            {"bytesPerSecond", receivedBytes / seconds},
+            {"maxStallMs", maxStall},
+        };
+        std::printf("%s\n", QJsonDocument{line}.toJson(QJsonDocument::Compact).constData());
+        std::fflush(stdout);
+        QTimer::singleShot(0, this, &Bench::next);
+    }
+
+    QString appId;
+    int clients;
+    int messages;
+    QList<int> sizes;
+    bool direct;
+    QtLocalPeer *peer;
+    int size = 0;
+    int running = 0;
+    qint64 received = 0;
+    qint64 receivedBytes = 0;
+    bool lost = false;
+    QHash<QProcess *, QByteArray> output;
+    QTimer heartbeat;
+    QElapsedTimer sinceBeat;
+    qint64 maxStall = 0;
+};
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app{argc, argv};
+    auto args = app.arguments();
+    if (args.value(1) == "--client")
+        return runClient(args.value(2), args.value(3).toInt(), args.value(4).toInt(),
+                         args.contains("--direct"));
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("QtLocalPeer round trip benchmark");
+    parser.addHelpOption();
+    QCommandLineOption clientsOption{"clients", "Concurrent client processes.", "N", "4"};
+    QCommandLineOption messagesOption{"messages", "Messages sent by each client.", "M", "500"};
+    QCommandLineOption sizesOption{"sizes", "Message sizes in bytes, comma separated.", "list",
+                                   "16,1024,65536,1000000"};
+    QCommandLineOption directOption{"direct", "Send with sendMessageDirect()."};
+    parser.addOptions({clientsOption, messagesOption, sizesOption, directOption});
+    parser.process(app);
+
+    int clients = parser.value(clientsOption).toInt();
+    int messages = parser.value(messagesOption).toInt();
+    QList<int> sizes;
+    for (const auto& s: parser.value(sizesOption).split(','))
+        sizes.append(s.toInt());
+    if (clients < 1 || messages < 1 || sizes.isEmpty()
+            || std::any_of(sizes.begin(), sizes.end(), [](int s) { return s < 0 || s > MAX_MESSAGE_SIZE; }))
+        parser.showHelp(2);
+
+    // a server of its own, whatever else is running
+    auto appId = QString{"peerbench-%1"}.arg(QCoreApplication::applicationPid());
+    Bench bench{appId, clients, messages, sizes, parser.isSet(directOption)};
+    if (!bench.listen()) {
+        std::fputs("cannot listen\n", stderr);
+        return 2;
+    }
+    QTimer::singleShot(0, &bench, &Bench::next);
+    return app.exec();
+}
@@ -0,0 +1,10 @@
+QT -= gui
+QT += network
+CONFIG += console c++17
+CONFIG -= app_bundle
+TARGET = peerbench
+
+PEER_SRC = ../../qtsingleapplication/src
+INCLUDEPATH += $$PEER_SRC
+SOURCES += main.cpp $$PEER_SRC/qtlocalpeer.cpp
+HEADERS += $$PEER_SRC/qtlocalpeer.h
@@ -0,0 +1,86 @@
+#include "cgroupfreezer.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+
+#include <QtDebug>
+
+constexpr auto CGROUP_ROOT = "/sys/fs/cgroup";
+
+static QString ownCgroup()
+{
+#ifdef Q_OS_LINUX
+    QFile f{"/proc/self/cgroup"};
+    if (!f.open(QFile::ReadOnly))
+        return {};
+    // the unified hierarchy is the "0::<path>" line
+    const auto lines = f.readAll().split('\n');
+    for (const auto& l: lines)
+        if (l.startsWith("0::"))
+            return CGROUP_ROOT + QString::fromLocal8Bit(l.mid(3).trimmed());
+#endif
+    return {};
+}
+
+static bool writeFile(const QString& path, const QByteArray& data)
+{
+    QFile f{path};
+    if (!f.open(QFile::WriteOnly) || f.write(data) != data.size()) {
+        qDebug() << "cannot write" << path << f.errorString();
+        return false;
+    }
+    return true;
+}
+
+bool CgroupFreezer::isAvailable()
+{
+    static const bool available = []() {
+        auto base = ownCgroup();
+        return !base.isEmpty()
+                && QFileInfo{base}.isWritable()
+                && QFileInfo{base + "/cgroup.procs"}.isWritable();
+    }();
+    return available;
+}
+
+CgroupFreezer::CgroupFreezer(qint64 pid)
+{
+    if (!isAvailable())
+        return;
+    // named after the pid of the application, so a restarted launcher
+    // reattaching to it finds the same cgroup again
+    auto dir = QString{"%1/applauncher-%2"}.arg(ownCgroup()).arg(pid);
+    bool reused = false;
+    if (!QDir{}.mkdir(dir)) {
+        reused = QFileInfo{dir}.isDir();
+        if (!reused) {
+            qDebug() << "cannot create cgroup" << dir;
+            return;
+        }
+    }
+    if (!writeFile(dir + "/cgroup.procs", QByteArray::number(pid))) {
+        if (!reused)
+            QDir{}.rmdir(dir);
+        return;
+    }
+    path = dir;
+    // left frozen by the previous launcher instance
+    if (reused)
+        setFrozen(false);
+}
+
+CgroupFreezer::~CgroupFreezer()
+{
+    if (path.isEmpty())
+        return;
+    setFrozen(false);
+    // fails while descendants that outlived the application are inside
+    if (!QDir{}.rmdir(path))
+        qDebug() << "cgroup left behind" << path;
+}
+
+bool CgroupFreezer::setFrozen(bool frozen)
+{
+    return isValid() && writeFile(path + "/cgroup.freeze", frozen? "1" : "0");
+}
@@ -0,0 +1,25 @@
+#ifndef CGROUPFREEZER_H
+#define CGROUPFREEZER_H
+
+#include <QString>
+
+// A child cgroup (v2) of the launcher's own cgroup holding one launched
+// application. Freezing it also stops the processes that left the
+// application process group, which SIGSTOP would miss.
+class CgroupFreezer
+{
+public:
+    // True when the launcher runs in a cgroup v2 delegated to its user
+    static bool isAvailable();
+
+    explicit CgroupFreezer(qint64 pid);
+    ~CgroupFreezer();
+
+    bool isValid() const { return !path.isEmpty(); }
+    bool setFrozen(bool frozen);
+
+private:
+    QString path;
+};
+
+#endif // CGROUPFREEZER_H
@@ -0,0 +1,95 @@
+#include "childregistry.h"
+
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+#include <QtDebug>
+
+constexpr auto CHILDREN_NAME = "children.json";
+constexpr auto LOGS_DIR = "logs";
+
+ChildRegistry::ChildRegistry(const QString &stateFile, QObject *parent)
+    : QObject{parent},
+      fileName{stateFile}
+{
+    load();
+}
+
+QString ChildRegistry::defaultStateFile()
+{
+    auto dir = QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation);
+    return QDir{dir}.filePath(CHILDREN_NAME);
+}
+
+QString ChildRegistry::logFile(const QString &key, const char *channel) const
+{
+    // keys are "<configuration file>#<entry name>": hash them into a
+    // file name
+    auto id = QCryptographicHash::hash(key.toUtf8(), QCryptographicHash::Sha1).toHex().left(16);
+    QDir dir{QFileInfo{fileName}.absolutePath()};
+    dir.mkpath(LOGS_DIR);
+    return dir.filePath(QString{"%1/%2.%3.log"}.arg(LOGS_DIR, QString::fromLatin1(id), channel));
+}
+
+void ChildRegistry::add(const QString &key, const Child &child)
+{
+    children.insert(key, child);
+    save();
+}
+
+void ChildRegistry::remove(const QString &key)
+{
+    if (children.remove(key))
+        save();
+}
+
+void ChildRegistry::load()
+{
+    QFile f{fileName};
+    if (!f.open(QFile::ReadOnly))
+        return;
+    QJsonParseError err;
+    auto doc = QJsonDocument::fromJson(f.readAll(), &err).object();
+    if (err.error != QJsonParseError::NoError) {
+        qDebug() << "Error loading " << fileName << ": " << err.errorString();
+        return;
+    }
+    for (auto it = doc.constBegin(); it != doc.constEnd(); ++it) {
+        auto o = it.value().toObject();
+        Child c;
+        c.pid = qint64(o.value("pid").toDouble());
+        c.startTime = quint64(o.value("startTime").toString().toULongLong());
+        c.stdoutLog = o.value("stdout").toString();
+        c.stderrLog = o.value("stderr").toString();
+        if (c.pid > 0)
+            children.insert(it.key(), c);
+    }
+}
+
+void ChildRegistry::save()
+{
+    QJsonObject doc;
+    for (auto it = children.constBegin(); it != children.constEnd(); ++it) {
+        doc.insert(it.key(), QJsonObject{
+                       {"pid", double(it->pid)},
+                       // may not fit in a double
+                       {"startTime", QString::number(it->startTime)},
+                       {"stdout", it->stdoutLog},
+                       {"stderr", it->stderrLog},
+                   });
+    }
+    QDir{}.mkpath(QFileInfo{fileName}.absolutePath());
+    QSaveFile f{fileName};
+    if (!f.open(QFile::WriteOnly)) {
+        qDebug() << "file error: " << fileName << "\n" << f.errorString();
+        return;
+    }
+    f.write(QJsonDocument{doc}.toJson(QJsonDocument::Compact));
+    f.commit();
+}
@@ -0,0 +1,41 @@
+#ifndef CHILDREGISTRY_H
+#define CHILDREGISTRY_H
+
+#include <QObject>
+#include <QHash>
+
+// Persists the applications that outlive the launcher (pid, kernel start
+// time and log files) so the next launcher instance can reattach to them.
+class ChildRegistry : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Child {
+        qint64 pid = 0;
+        quint64 startTime = 0;
+        QString stdoutLog;
+        QString stderrLog;
+    };
+
+    explicit ChildRegistry(const QString& stateFile, QObject *parent = nullptr);
+
+    static QString defaultStateFile();
+
+    // Log files of the application known as key
+    QString logFile(const QString& key, const char *channel) const;
+
+    bool contains(const QString& key) const { return children.contains(key); }
+    Child child(const QString& key) const { return children.value(key); }
+    void add(const QString& key, const Child& child);
+    void remove(const QString& key);
+
+private:
+    void load();
+    void save();
+
+    QString fileName;
+    QHash<QString, Child> children;
+};
+
+#endif // CHILDREGISTRY_H
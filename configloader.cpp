@@ -0,0 +1,159 @@
+#include "configloader.h"
+
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QThreadPool>
+#include <QVector>
+
+#include <QtDebug>
+
+#include <algorithm>
+#include <numeric>
+
+constexpr auto FRAGMENT_SUFFIX = ".d";
+constexpr auto FRAGMENT_PATTERN = "*.json";
+constexpr auto PRIORITY_KEY = "mergePriority";
+
+// Arrays are appended, objects merged key by key and anything else
+// replaced, so fragments add applications, path and env entries
+static void merge(QJsonObject& into, const QJsonObject& from)
+{
+    for (auto it = from.constBegin(); it != from.constEnd(); ++it) {
+        if (it.key() == PRIORITY_KEY)
+            continue;
+        auto current = into.value(it.key());
+        if (current.isArray() && it.value().isArray()) {
+            auto a = current.toArray();
+            auto add = it.value().toArray();
+            for (const auto& v: qAsConst(add))
+                a.append(v);
+            into.insert(it.key(), a);
+        } else if (current.isObject() && it.value().isObject()) {
+            auto o = current.toObject();
+            auto add = it.value().toObject();
+            for (auto j = add.constBegin(); j != add.constEnd(); ++j)
+                o.insert(j.key(), j.value());
+            into.insert(it.key(), o);
+        } else {
+            into.insert(it.key(), it.value());
+        }
+    }
+}
+
+ConfigLoader::ConfigLoader(QObject *parent)
+    : QObject{parent},
+      pool{new QThreadPool{this}}
+{
+}
+
+ConfigLoader::~ConfigLoader()
+{
+    pool->waitForDone();
+}
+
+QString ConfigLoader::fragmentDirectory(const QString &file)
+{
+    QFileInfo info{file};
+    return info.dir().filePath(info.completeBaseName() + FRAGMENT_SUFFIX);
+}
+
+ConfigLoader::Parsed ConfigLoader::parse(const QString &path)
+{
+    Parsed r;
+    QFileInfo info{path};
+    // taken before reading, so a change while reading is parsed next time
+    r.modified = info.lastModified();
+    r.size = info.size();
+    QFile f{path};
+    if (!f.open(QFile::ReadOnly)) {
+        r.error = f.errorString();
+        return r;
+    }
+    QJsonParseError err;
+    auto doc = QJsonDocument::fromJson(f.readAll(), &err);
+    if (err.error != QJsonParseError::NoError)
+        r.error = QString{"%1 at offset %2"}.arg(err.errorString()).arg(err.offset);
+    else if (!doc.isObject())
+        r.error = "not a JSON object";
+    else
+        r.doc = doc.object();
+    return r;
+}
+
+QJsonObject ConfigLoader::load(const QString &file)
+{
+    QElapsedTimer t;
+    t.start();
+    QStringList errors;
+
+    QStringList paths{file};
+    QDir dir{fragmentDirectory(file)};
+    auto names = dir.entryList({ FRAGMENT_PATTERN }, QDir::Files | QDir::Readable, QDir::Name);
+    for (const auto& name: qAsConst(names))
+        paths.append(dir.filePath(name));
+    // forget the fragments removed since the previous load
+    auto previous = filesOf.value(file);
+    for (const auto& path: qAsConst(previous))
+        if (!paths.contains(path))
+            cache.remove(path);
+    filesOf.insert(file, paths);
+
+    QVector<Parsed> parsed(paths.size());
+    QVector<int> stale;
+    for (int i = 0; i < paths.size(); i++) {
+        QFileInfo info{paths[i]};
+        if (!info.exists()) {
+            qDebug() << "no configuration file" << paths[i];
+            cache.remove(paths[i]);
+            continue;
+        }
+        auto it = cache.constFind(paths[i]);
+        if (it != cache.cend() && it->modified == info.lastModified() && it->size == info.size())
+            parsed[i] = *it;
+        else
+            stale.append(i);
+    }
+    if (stale.size() == 1) {
+        parsed[stale.first()] = parse(paths[stale.first()]);
+    } else if (!stale.isEmpty()) {
+        // every task writes its own slot; waitForDone() publishes them
+        auto results = parsed.data();
+        for (int i: qAsConst(stale)) {
+            auto path = paths[i];
+            pool->start([results, i, path]() { results[i] = parse(path); });
+        }
+        pool->waitForDone();
+    }
+    for (int i: qAsConst(stale))
+        cache.insert(paths[i], parsed[i]);
+
+    // the file itself comes first, then the fragments in a stable order
+    QVector<int> order(paths.size() - 1);
+    std::iota(order.begin(), order.end(), 1);
+    std::stable_sort(order.begin(), order.end(), [&parsed](int a, int b) {
+        return parsed[a].doc.value(PRIORITY_KEY).toInt() < parsed[b].doc.value(PRIORITY_KEY).toInt();
+    });
+    order.prepend(0);
+
+    QJsonObject config;
+    for (int i: qAsConst(order)) {
+        if (!parsed[i].error.isEmpty()) {
+            qWarning() << "Error loading" << paths[i] << ":" << parsed[i].error;
+            errors.append(QString{"%1: %2"}.arg(paths[i], parsed[i].error));
+            continue;
+        }
+        merge(config, parsed[i].doc);
+    }
+    if (!parsed[0].error.isEmpty() && !config.isEmpty()) {
+        qWarning() << "using the fragments of" << file << "alone";
+        errors.append(QString{"%1: left out, the configuration holds its fragments alone"}.arg(file));
+    }
+    errorsOf.insert(file, errors);
+    qDebug() << "configuration" << file << "with" << paths.size() - 1 << "fragments,"
+             << stale.size() << "parsed in" << t.nsecsElapsed() / 1000 << "us";
+    return config;
+}
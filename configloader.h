@@ -0,0 +1,51 @@
+#ifndef CONFIGLOADER_H
+#define CONFIGLOADER_H
+
+#include <QObject>
+#include <QDateTime>
+#include <QHash>
+#include <QJsonObject>
+#include <QStringList>
+
+class QThreadPool;
+
+// Loads a configuration file together with the fragments of its ".d"
+// directory (launcher-conf.json and launcher-conf.d/*.json). Fragments are
+// parsed on a thread pool and merged into the file by "mergePriority",
+// then by file name; one that fails to parse is reported and left out.
+// Parsed files are kept with their modification time and size, so
+// loading the same configuration again only parses what changed.
+class ConfigLoader : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ConfigLoader(QObject *parent = nullptr);
+    ~ConfigLoader() override;
+
+    static QString fragmentDirectory(const QString& file);
+
+    // The merged configuration; empty when neither the file nor any
+    // fragment could be loaded. A broken file with valid fragments gives
+    // the fragments alone, which errors() reports.
+    QJsonObject load(const QString& file);
+    // "<file>: <error>" for every file the last load of file left out
+    QStringList errors(const QString& file) const { return errorsOf.value(file); }
+
+private:
+    struct Parsed {
+        QDateTime modified;
+        qint64 size = -1;
+        QJsonObject doc;
+        QString error;
+    };
+
+    static Parsed parse(const QString& path);
+
+    QThreadPool *pool;
+    QHash<QString, Parsed> cache;
+    QHash<QString, QStringList> filesOf;
+    QHash<QString, QStringList> errorsOf;
+};
+
+#endif // CONFIGLOADER_H
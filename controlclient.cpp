@@ -0,0 +1,275 @@
+#include "controlclient.h"
+#include "controlserver.h"
+
+#include <QCborArray>
+#include <QCborValue>
+#include <QElapsedTimer>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QtEndian>
+#include <qtlocalpeer.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#ifdef Q_OS_UNIX
+#include <cerrno>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#endif
+
+constexpr auto CONTROL_TIMEOUT = 5000;
+// Leaves room for the framing under the server frame limit
+constexpr auto MAX_BENCH_SIZE = 512 * 1024;
+
+static int usage()
+{
+    std::fputs("usage: applauncher --ctl list\n"
+               "       applauncher --ctl status [name...]\n"
+               "       applauncher --ctl start|stop|restart <name>...\n"
+               "       applauncher --ctl tail <name> [lines]\n"
+               "       applauncher --ctl watch [--output] [name...]\n"
+               "       applauncher --ctl bench [requests] [bytes] [clients]\n", stderr);
+    return 2;
+}
+
+#ifdef Q_OS_UNIX
+static bool readFully(int fd, char *buf, size_t size)
+{
+    size_t got = 0;
+    while (got < size) {
+        auto n = ::read(fd, buf + got, size - got);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return false;
+        got += size_t(n);
+    }
+    return true;
+}
+
+static bool writeFully(int fd, const QByteArray &data)
+{
+    qint64 done = 0;
+    while (done < data.size()) {
+        auto n = ::write(fd, data.constData() + done, size_t(data.size() - done));
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return false;
+        done += n;
+    }
+    return true;
+}
+
+// Reads one length-prefixed frame; a length over the server's own limit
+// means a broken stream and is not allocated
+static bool readFrame(int fd, QByteArray *payload, bool *tooLarge)
+{
+    *tooLarge = false;
+    uchar header[sizeof(quint32)];
+    if (!readFully(fd, reinterpret_cast<char *>(header), sizeof(header)))
+        return false;
+    auto size = qFromBigEndian<quint32>(header);
+    if (size > ControlServer::MAX_FRAME_SIZE) {
+        std::fprintf(stderr, "reply frame too large: %u bytes\n", size);
+        *tooLarge = true;
+        return false;
+    }
+    payload->resize(int(size));
+    return readFully(fd, payload->data(), size);
+}
+
+struct BenchClient {
+    std::vector<qint64> latencies;
+    qint64 bytes = 0;
+};
+
+// Sends count echo requests one after the other on one connection
+static void benchClient(QString appId, int count, QByteArray frame, BenchClient *result)
+{
+    int fd = QtLocalPeer::connectDirect(appId, CONTROL_TIMEOUT);
+    if (fd < 0)
+        return;
+    result->latencies.reserve(size_t(count));
+    QByteArray reply;
+    bool tooLarge = false;
+    QElapsedTimer t;
+    for (int i = 0; i < count; i++) {
+        t.start();
+        if (!writeFully(fd, frame) || !readFrame(fd, &reply, &tooLarge))
+            break;
+        result->latencies.push_back(t.nsecsElapsed());
+        result->bytes += frame.size() + qint64(sizeof(quint32)) + reply.size();
+    }
+    ::close(fd);
+}
+#endif
+
+// Measures the local socket round trip: each of the clients sends requests
+// ping commands carrying bytes of data, all the clients at the same time
+static int bench(const QString& appId, const QStringList& args)
+{
+#ifdef Q_OS_UNIX
+    int count = args.value(0, "1000").toInt();
+    int size = args.value(1, "64").toInt();
+    int clients = args.value(2, "1").toInt();
+    if (count < 1 || size < 0 || size > MAX_BENCH_SIZE || clients < 1)
+        return usage();
+    QCborMap ping{{"cmd", "ping"}, {"data", QByteArray(size, 'x')}};
+    auto frame = ControlServer::encodeFrame(QCborMap{{"v", ControlServer::VERSION},
+                                                     {"commands", QCborArray{ping}}});
+
+    std::vector<BenchClient> results(size_t(clients), BenchClient{});
+    std::vector<std::thread> threads;
+    QElapsedTimer wall;
+    wall.start();
+    for (auto& r: results)
+        threads.emplace_back(benchClient, appId, count, frame, &r);
+    for (auto& t: threads)
+        t.join();
+    double seconds = wall.nsecsElapsed() / 1e9;
+
+    std::vector<qint64> all;
+    qint64 bytes = 0;
+    bool complete = true;
+    for (const auto& r: results) {
+        all.insert(all.end(), r.latencies.begin(), r.latencies.end());
+        bytes += r.bytes;
+        complete = complete && r.latencies.size() == size_t(count);
+    }
+    if (all.empty()) {
+        std::fputs("applauncher is not running\n", stderr);
+        return 2;
+    }
+    std::sort(all.begin(), all.end());
+    auto percentile = [&all](size_t p) {
+        return all.at(qMin(all.size() - 1, all.size() * p / 100)) / 1000.0;
+    };
+    QJsonObject report{
+        {"clients", clients},
+        {"requests", qint64(all.size())},
+        {"bytes", size},
+        {"p50us", percentile(50)},
+        {"p99us", percentile(99)},
+        {"requestsPerSecond", all.size() / seconds},
+        {"bytesPerSecond", bytes / seconds},
+    };
+    auto json = QJsonDocument{report}.toJson(QJsonDocument::Indented);
+    std::fwrite(json.constData(), 1, size_t(json.size()), stdout);
+    return complete? 0 : 1;
+#else
+    Q_UNUSED(appId)
+    Q_UNUSED(args)
+    std::fputs("bench is not supported on this platform\n", stderr);
+    return 2;
+#endif
+}
+
+// Subscribes and prints every event as a line of JSON until the launcher
+// goes away
+static int watch(const QString& appId, QStringList names)
+{
+#ifdef Q_OS_UNIX
+    bool output = names.removeAll("--output") > 0;
+    QCborArray nameArray;
+    for (const auto& n: qAsConst(names))
+        nameArray.append(n);
+    QCborMap subscribe{{"cmd", "subscribe"}, {"output", output}};
+    if (!nameArray.isEmpty())
+        subscribe.insert(QString{"names"}, nameArray);
+    auto frame = ControlServer::encodeFrame(QCborMap{{"v", ControlServer::VERSION},
+                                                     {"commands", QCborArray{subscribe}}});
+    int fd = QtLocalPeer::connectDirect(appId, CONTROL_TIMEOUT);
+    if (fd < 0) {
+        std::fputs("applauncher is not running\n", stderr);
+        return 2;
+    }
+    // events may be far apart
+    struct timeval forever = { 0, 0 };
+    ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &forever, sizeof(forever));
+    if (!writeFully(fd, frame)) {
+        ::close(fd);
+        return 2;
+    }
+    QByteArray payload;
+    bool tooLarge = false;
+    while (readFrame(fd, &payload, &tooLarge)) {
+        auto map = ControlServer::decodePayload(payload);
+        if (!map.contains(QString{"event"})) {
+            // the reply to the subscription
+            auto result = map.value("results").toArray().at(0).toMap();
+            if (!result.value("ok").toBool()) {
+                std::fprintf(stderr, "%s\n", qPrintable(result.value("error").toString()));
+                ::close(fd);
+                return 1;
+            }
+            continue;
+        }
+        auto json = QJsonDocument{map.toJsonObject()}.toJson(QJsonDocument::Compact);
+        std::fprintf(stdout, "%s\n", json.constData());
+        std::fflush(stdout);
+    }
+    ::close(fd);
+    return tooLarge? 2 : 0;
+#else
+    Q_UNUSED(appId)
+    Q_UNUSED(names)
+    std::fputs("watch is not supported on this platform\n", stderr);
+    return 2;
+#endif
+}
+
+int runControl(const QString &appId, const QStringList &args)
+{
+    if (args.isEmpty())
+        return usage();
+    if (args.first() == "watch")
+        return watch(appId, args.mid(1));
+    if (args.first() == "bench")
+        return bench(appId, args.mid(1));
+    auto cmd = args.first();
+    auto names = args.mid(1);
+    QCborArray commands;
+    if (cmd == "list" || (cmd == "status" && names.isEmpty())) {
+        commands.append(QCborMap{{"cmd", cmd}});
+    } else if (cmd == "tail") {
+        if (names.isEmpty())
+            return usage();
+        QCborMap c{{"cmd", cmd}, {"name", names.first()}};
+        if (names.size() > 1)
+            c.insert(QString{"lines"}, names.at(1).toInt());
+        commands.append(c);
+    } else if (cmd == "status" || cmd == "start" || cmd == "stop" || cmd == "restart") {
+        if (names.isEmpty())
+            return usage();
+        // one request for all the names
+        for (const auto& n: qAsConst(names))
+            commands.append(QCborMap{{"cmd", cmd}, {"name", n}});
+    } else {
+        return usage();
+    }
+
+    QCborMap request{{"v", ControlServer::VERSION}, {"commands", commands}};
+    auto payload = QCborValue{QCborKnownTags::Signature, request}.toCbor();
+    auto reply = QtLocalPeer::requestDirect(appId, payload, CONTROL_TIMEOUT);
+    if (reply.isNull()) {
+        std::fputs("applauncher is not running\n", stderr);
+        return 2;
+    }
+    auto map = ControlServer::decodePayload(reply);
+    if (map.contains(QString{"error"})) {
+        std::fprintf(stderr, "%s\n", qPrintable(map.value("error").toString()));
+        return 2;
+    }
+    auto results = map.value("results").toArray();
+    bool ok = true;
+    for (const auto& r: qAsConst(results))
+        ok = ok && r.toMap().value("ok").toBool();
+    auto json = QJsonDocument{results.toJsonArray()}.toJson(QJsonDocument::Indented);
+    std::fwrite(json.constData(), 1, size_t(json.size()), stdout);
+    return ok? 0 : 1;
+}
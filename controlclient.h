@@ -0,0 +1,10 @@
+#ifndef CONTROLCLIENT_H
+#define CONTROLCLIENT_H
+
+#include <QStringList>
+
+// "--ctl" mode: sends one batched control request to the running
+// instance and prints the results as JSON. Runs before QApplication.
+int runControl(const QString& appId, const QStringList& args);
+
+#endif // CONTROLCLIENT_H
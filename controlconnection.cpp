@@ -0,0 +1,92 @@
+#include "controlconnection.h"
+#include "controlserver.h"
+
+#include <QLocalSocket>
+#include <QtEndian>
+#include <qtlocalpeer.h>
+
+#include <QtDebug>
+
+// Only for connecting: the instance is local, it answers at once or not
+constexpr auto CONNECT_TIMEOUT = 1000;
+
+ControlConnection::ControlConnection(QObject *parent)
+    : QObject{parent},
+      socket{nullptr}
+{
+}
+
+bool ControlConnection::open(const QString &appId)
+{
+    close();
+    int fd = QtLocalPeer::connectDirect(appId, CONNECT_TIMEOUT);
+    if (fd < 0)
+        return false;
+    socket = new QLocalSocket{this};
+    if (!socket->setSocketDescriptor(fd)) {
+        qWarning() << "control connection:" << socket->errorString();
+        delete socket;
+        socket = nullptr;
+        return false;
+    }
+    connect(socket, &QLocalSocket::readyRead, this, &ControlConnection::readFrames);
+    connect(socket, &QLocalSocket::disconnected, this, [this]() {
+        close();
+        emit closed();
+    });
+    return true;
+}
+
+void ControlConnection::close()
+{
+    if (!socket)
+        return;
+    socket->disconnect(this);
+    socket->abort();
+    socket->deleteLater();
+    socket = nullptr;
+    buffer.clear();
+    handlers.clear();
+}
+
+void ControlConnection::request(const QCborArray &commands, const ReplyHandler &handler)
+{
+    if (!socket)
+        return;
+    handlers.enqueue(handler);
+    socket->write(ControlServer::encodeFrame(QCborMap{{"v", ControlServer::VERSION},
+                                                      {"commands", commands}}));
+}
+
+void ControlConnection::readFrames()
+{
+    auto current = socket;
+    buffer.append(socket->readAll());
+    int offset = 0;
+    while (buffer.size() - offset >= int(sizeof(quint32))) {
+        auto size = qFromBigEndian<quint32>(buffer.constData() + offset);
+        if (size > ControlServer::MAX_FRAME_SIZE) {
+            qWarning() << "control frame too large:" << size << "bytes";
+            close();
+            emit closed();
+            return;
+        }
+        if (quint32(buffer.size() - offset) - sizeof(quint32) < size)
+            break;
+        auto map = ControlServer::decodePayload(buffer.mid(offset + int(sizeof(quint32)), int(size)));
+        offset += int(sizeof(quint32) + size);
+        if (map.contains(QString{"event"})) {
+            emit event(map);
+        } else if (!handlers.isEmpty()) {
+            auto handler = handlers.dequeue();
+            if (map.contains(QString{"error"}))
+                qWarning() << "control request failed:" << map.value("error").toString();
+            if (handler)
+                handler(map.value("results").toArray());
+        }
+        // a handler may have closed or reopened the connection
+        if (socket != current)
+            return;
+    }
+    buffer.remove(0, offset);
+}
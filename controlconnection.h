@@ -0,0 +1,45 @@
+#ifndef CONTROLCONNECTION_H
+#define CONTROLCONNECTION_H
+
+#include <QObject>
+#include <QCborArray>
+#include <QCborMap>
+#include <QQueue>
+
+#include <functional>
+
+class QLocalSocket;
+
+// Client side of the control protocol (see ControlServer) for front-ends
+// running an event loop: nothing blocks, the replies are handed to the
+// handler given with each request, in order, and the frames of a
+// subscription come out as event().
+class ControlConnection : public QObject
+{
+    Q_OBJECT
+
+public:
+    using ReplyHandler = std::function<void(const QCborArray& results)>;
+
+    explicit ControlConnection(QObject *parent = nullptr);
+
+    // Connects to the instance running appId, false when there is none
+    bool open(const QString& appId);
+    bool isOpen() const { return socket != nullptr; }
+    void close();
+
+    void request(const QCborArray& commands, const ReplyHandler& handler = {});
+
+signals:
+    void event(const QCborMap& event);
+    void closed();
+
+private:
+    void readFrames();
+
+    QLocalSocket *socket;
+    QByteArray buffer;
+    QQueue<ReplyHandler> handlers;
+};
+
+#endif // CONTROLCONNECTION_H
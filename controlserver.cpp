@@ -0,0 +1,372 @@
+#include "controlserver.h"
+#include "launchgroups.h"
+#include "launchentry.h"
+#include "launcherengine.h"
+
+#include <QCborArray>
+#include <QCborValue>
+#include <QLocalSocket>
+#include <QTimer>
+#include <QtEndian>
+
+#include <QtDebug>
+
+constexpr auto DEFAULT_TAIL_LINES = 20;
+constexpr auto DEFAULT_QUEUE_LIMIT = 1000;
+// Stop handing frames to a subscriber socket past this many unsent bytes
+constexpr auto WRITE_HIGH_WATER = 64 * 1024;
+// Connections that send nothing for this long are closed, unless they
+// subscribed to events and are only listening
+constexpr auto IDLE_TIMEOUT_MS = 60 * 1000;
+
+static QString stateName(QProcess::ProcessState state)
+{
+    switch (state) {
+    case QProcess::NotRunning:
+        return "stopped";
+    case QProcess::Starting:
+        return "starting";
+    case QProcess::Running:
+        return "running";
+    }
+    return {};
+}
+
+static QCborMap failure(const QString& error)
+{
+    return QCborMap{{"ok", false}, {"error", error}};
+}
+
+static QString qualified(const QString& prefix, const QString& name)
+{
+    return prefix.isEmpty()? name : prefix + '/' + name;
+}
+
+ControlServer::ControlServer(QObject *parent)
+    : QObject{parent},
+      requester{nullptr},
+      watching{false}
+{
+}
+
+void ControlServer::addEngine(LauncherEngine *engine)
+{
+    sources.append(Source{engine->prefix(), engine->groups(), engine});
+    if (watching)
+        watchEntries(engine->groups(), engine->prefix());
+}
+
+QStringList ControlServer::names() const
+{
+    QStringList list;
+    for (const auto& source: sources) {
+        const auto names = source.groups->names();
+        for (const auto& n: names)
+            list.append(qualified(source.prefix, n));
+    }
+    return list;
+}
+
+LaunchEntry *ControlServer::item(const QString &name) const
+{
+    for (const auto& source: sources) {
+        if (source.prefix.isEmpty()) {
+            if (auto i = source.groups->item(name))
+                return i;
+        } else if (name.startsWith(source.prefix + '/')) {
+            if (auto i = source.groups->item(name.mid(source.prefix.size() + 1)))
+                return i;
+        }
+    }
+    return nullptr;
+}
+
+QByteArray ControlServer::encodeFrame(const QCborMap &map)
+{
+    auto payload = QCborValue{QCborKnownTags::Signature, map}.toCbor();
+    QByteArray frame(sizeof(quint32), '\0');
+    qToBigEndian<quint32>(quint32(payload.size()), frame.data());
+    return frame + payload;
+}
+
+QCborMap ControlServer::decodePayload(const QByteArray &payload)
+{
+    auto v = QCborValue::fromCbor(payload);
+    if (v.isTag())
+        v = v.taggedValue();
+    return v.toMap();
+}
+
+void ControlServer::addConnection(QLocalSocket *socket, const QByteArray &received)
+{
+    socket->setParent(this);
+    buffers.insert(socket, received);
+    // the handshake timer of QtLocalPeer is gone with the handoff
+    auto idleTimer = new QTimer{socket};
+    idleTimer->setSingleShot(true);
+    idleTimer->setInterval(IDLE_TIMEOUT_MS);
+    idleTimers.insert(socket, idleTimer);
+    connect(idleTimer, &QTimer::timeout, this, [this, socket]() {
+        qDebug() << "closing idle control connection";
+        dropConnection(socket);
+    });
+    connect(socket, &QLocalSocket::readyRead, this, [this, socket]() { readRequests(socket); });
+    connect(socket, &QLocalSocket::bytesWritten, this, [this, socket]() { flush(socket); });
+    connect(socket, &QLocalSocket::disconnected, this, [this, socket]() { dropConnection(socket); });
+    readRequests(socket);
+}
+
+void ControlServer::dropConnection(QLocalSocket *socket)
+{
+    if (!buffers.remove(socket))
+        return;
+    subscribers.remove(socket);
+    idleTimers.remove(socket);
+    socket->abort();
+    socket->deleteLater();
+}
+
+void ControlServer::restartIdleTimer(QLocalSocket *socket)
+{
+    auto timer = idleTimers.value(socket);
+    if (!timer)
+        return;
+    if (subscribers.contains(socket))
+        timer->stop();
+    else
+        timer->start();
+}
+
+void ControlServer::readRequests(QLocalSocket *socket)
+{
+    auto it = buffers.find(socket);
+    if (it == buffers.end())
+        return;
+    it->append(socket->readAll());
+    int offset = 0;
+    while (it->size() - offset >= int(sizeof(quint32))) {
+        auto size = qFromBigEndian<quint32>(it->constData() + offset);
+        if (size > MAX_FRAME_SIZE) {
+            qWarning() << "control request too large:" << size << "bytes";
+            dropConnection(socket);
+            return;
+        }
+        if (quint32(it->size() - offset) - sizeof(quint32) < size)
+            break;
+        auto payload = it->mid(offset + int(sizeof(quint32)), int(size));
+        offset += int(sizeof(quint32) + size);
+        requester = socket;
+        auto reply = encodeFrame(handleRequest(decodePayload(payload)));
+        requester = nullptr;
+        socket->write(reply);
+        // the reply may have started something that closed this connection
+        it = buffers.find(socket);
+        if (it == buffers.end())
+            return;
+    }
+    it->remove(0, offset);
+    restartIdleTimer(socket);
+}
+
+QCborMap ControlServer::handleRequest(const QCborMap &request)
+{
+    QCborMap reply{{"v", VERSION}};
+    if (request.value("v").toInteger() != VERSION) {
+        reply.insert(QString{"error"}, QString{"unsupported protocol version"});
+        return reply;
+    }
+    QCborArray results;
+    const auto commands = request.value("commands").toArray();
+    for (const auto& c: commands)
+        results.append(handleCommand(c.toMap()));
+    reply.insert(QString{"results"}, results);
+    return reply;
+}
+
+QCborMap ControlServer::handleCommand(const QCborMap &command)
+{
+    auto cmd = command.value("cmd").toString();
+    if (cmd == "subscribe")
+        return subscribe(requester, command);
+    if (cmd == "unsubscribe") {
+        subscribers.remove(requester);
+        return QCborMap{{"ok", true}};
+    }
+    if (cmd == "ping")
+        return QCborMap{{"ok", true}, {"data", command.value("data")}};
+    if (cmd == "list") {
+        QCborArray list;
+        const auto all = names();
+        for (const auto& n: all)
+            list.append(entryStatus(n, item(n)));
+        return QCborMap{{"ok", true}, {"entries", list}};
+    }
+
+    if (cmd == "status" && !command.contains(QString{"name"})) {
+        auto status = launcherStatus();
+        status.insert(QString{"ok"}, true);
+        return status;
+    }
+    auto name = command.value("name").toString();
+    auto entry = item(name);
+    if (!entry)
+        return failure(QString{"unknown entry: %1"}.arg(name));
+    if (cmd == "status") {
+        auto status = entryStatus(name, entry);
+        status.insert(QString{"ok"}, true);
+        return status;
+    }
+    if (cmd == "start") {
+        if (!entry->isAvailable())
+            return failure("command not found");
+        if (entry->state() == QProcess::NotRunning && !entry->isQueued())
+            entry->start();
+    } else if (cmd == "stop") {
+        if (entry->isQueued())
+            entry->startStop();
+        else if (entry->state() != QProcess::NotRunning)
+            entry->stop();
+    } else if (cmd == "restart") {
+        entry->restart();
+    } else if (cmd == "tail") {
+        auto lines = int(command.value("lines").toInteger(DEFAULT_TAIL_LINES));
+        auto output = entry->recentOutput();
+        int from = output.size();
+        if (output.endsWith('\n'))
+            from--;
+        while (lines-- > 0 && from > 0)
+            from = output.lastIndexOf('\n', from - 1);
+        return QCborMap{{"ok", true}, {"output", QString::fromLocal8Bit(output.mid(from + 1))}};
+    } else {
+        return failure(QString{"unknown command: %1"}.arg(cmd));
+    }
+    return QCborMap{{"ok", true}};
+}
+
+QCborMap ControlServer::entryStatus(const QString &name, LaunchEntry *entry) const
+{
+    return QCborMap{
+        {"name", name},
+        {"text", entry->text()},
+        {"icon", entry->iconName()},
+        {"state", stateName(entry->state())},
+        {"pid", entry->processId()},
+        {"available", entry->isAvailable()},
+        {"ready", entry->isReady()},
+        {"failed", entry->isFailed()},
+        {"frozen", entry->isFrozen()},
+        {"queued", entry->isQueued()},
+    };
+}
+
+QCborMap ControlServer::launcherStatus() const
+{
+    QCborArray configurations;
+    bool ok = true;
+    for (const auto& source: sources) {
+        const auto errors = source.engine->loadErrors();
+        ok = ok && errors.isEmpty();
+        configurations.append(QCborMap{
+            {"file", source.engine->file()},
+            {"prefix", source.prefix},
+            {"entries", source.groups->names().size()},
+            {"errors", QCborArray::fromStringList(errors)},
+        });
+    }
+    return QCborMap{{"configurations", configurations}, {"configurationsOk", ok}};
+}
+
+QCborMap ControlServer::subscribe(QLocalSocket *socket, const QCborMap &command)
+{
+    if (!socket)
+        return failure("no connection");
+    Subscriber sub{{}, command.value("output").toBool(),
+                   int(command.value("queueLimit").toInteger(DEFAULT_QUEUE_LIMIT)),
+                   {}, 0, false};
+    sub.queueLimit = qMax(sub.queueLimit, 1);
+    const auto names = command.value("names").toArray();
+    for (const auto& n: names) {
+        if (!item(n.toString()))
+            return failure(QString{"unknown entry: %1"}.arg(n.toString()));
+        sub.names.insert(n.toString());
+    }
+    subscribers.insert(socket, sub);
+    watchEntries();
+    return QCborMap{{"ok", true}, {"queueLimit", sub.queueLimit}};
+}
+
+void ControlServer::watchEntries()
+{
+    if (watching)
+        return;
+    watching = true;
+    for (const auto& source: qAsConst(sources))
+        watchEntries(source.groups, source.prefix);
+}
+
+void ControlServer::watchEntries(LaunchGroups *groups, const QString &prefix)
+{
+    const auto names = groups->names();
+    for (const auto& n: names) {
+        auto entry = groups->item(n);
+        auto name = qualified(prefix, n);
+        connect(entry, &LaunchEntry::stateChange, this, [this, name](bool started) {
+            if (started)
+                publish(name, QCborMap{{"event", "started"}});
+        });
+        connect(entry, &LaunchEntry::readyChanged, this, [this, name](bool ready) {
+            if (ready)
+                publish(name, QCborMap{{"event", "ready"}});
+        });
+        connect(entry, &LaunchEntry::exited, this, [this, name](int exitCode, bool crashed) {
+            publish(name, QCborMap{{"event", "exited"}, {"exitCode", exitCode}, {"crashed", crashed}});
+        });
+        connect(entry, &LaunchEntry::restarted, this, [this, name]() {
+            publish(name, QCborMap{{"event", "restarted"}});
+        });
+        connect(entry, &LaunchEntry::outputReceived, this, [this, name](const QByteArray& data, bool isError) {
+            publish(name, QCborMap{{"event", "output"},
+                                   {"stream", isError? "stderr" : "stdout"},
+                                   {"data", QString::fromLocal8Bit(data)}}, true);
+        });
+    }
+}
+
+void ControlServer::publish(const QString &name, QCborMap event, bool isOutput)
+{
+    if (subscribers.isEmpty())
+        return;
+    // encoded once, shared by all the queues
+    QByteArray frame;
+    for (auto it = subscribers.begin(); it != subscribers.end(); ++it) {
+        auto& sub = it.value();
+        if ((isOutput && !sub.output) || (!sub.names.isEmpty() && !sub.names.contains(name)))
+            continue;
+        if (sub.queue.size() >= sub.queueLimit) {
+            sub.dropped++;
+            sub.droppedNoticePending = true;
+            continue;
+        }
+        if (sub.droppedNoticePending) {
+            sub.droppedNoticePending = false;
+            sub.queue.enqueue(encodeFrame(QCborMap{{"v", VERSION}, {"event", "dropped"},
+                                                   {"count", qint64(sub.dropped)}}));
+        }
+        if (frame.isNull()) {
+            event.insert(QString{"v"}, VERSION);
+            event.insert(QString{"name"}, name);
+            frame = encodeFrame(event);
+        }
+        sub.queue.enqueue(frame);
+        flush(it.key());
+    }
+}
+
+void ControlServer::flush(QLocalSocket *socket)
+{
+    auto it = subscribers.find(socket);
+    if (it == subscribers.end())
+        return;
+    while (!it->queue.isEmpty() && socket->bytesToWrite() < WRITE_HIGH_WATER)
+        socket->write(it->queue.dequeue());
+}
@@ -0,0 +1,89 @@
+#ifndef CONTROLSERVER_H
+#define CONTROLSERVER_H
+
+#include <QObject>
+#include <QHash>
+#include <QCborMap>
+#include <QQueue>
+#include <QSet>
+#include <QVector>
+
+class QLocalSocket;
+class QTimer;
+class LaunchGroups;
+class LaunchEntry;
+class LauncherEngine;
+
+// Serves the control protocol on the connections QtLocalPeer hands over.
+// Every frame is a big endian quint32 length followed by a CBOR map
+// tagged as self-describing CBOR:
+//   request {"v": 1, "commands": [{"cmd": "start", "name": "..."}, ...]}
+//   reply   {"v": 1, "results": [{"ok": true, ...}, ...]}
+// one reply per request, results in the order of the commands. After a
+// "subscribe" command the connection also receives event frames
+//   {"v": 1, "event": "started", "name": "...", ...}
+// through a bounded queue: a subscriber that does not keep up loses
+// events (and is told how many) instead of slowing the launcher down.
+// Entries of every hosted configuration are served; those of additional
+// configurations are named "<prefix>/<name>". A "status" command without
+// a name reports the configurations and the errors met loading them.
+class ControlServer : public QObject
+{
+    Q_OBJECT
+
+public:
+    static constexpr int VERSION = 1;
+    // Larger frames are refused, by the server and by the --ctl client
+    static constexpr quint32 MAX_FRAME_SIZE = 1024 * 1024;
+
+    explicit ControlServer(QObject *parent = nullptr);
+
+    void addEngine(LauncherEngine *engine);
+
+    // Framing shared with the --ctl client
+    static QByteArray encodeFrame(const QCborMap& map);
+    static QCborMap decodePayload(const QByteArray& payload);
+
+public slots:
+    void addConnection(QLocalSocket *socket, const QByteArray& received);
+
+private:
+    void dropConnection(QLocalSocket *socket);
+    void restartIdleTimer(QLocalSocket *socket);
+    void readRequests(QLocalSocket *socket);
+    QCborMap handleRequest(const QCborMap& request);
+    QCborMap handleCommand(const QCborMap& command);
+    QStringList names() const;
+    LaunchEntry *item(const QString& name) const;
+    QCborMap entryStatus(const QString& name, LaunchEntry *entry) const;
+    QCborMap launcherStatus() const;
+    QCborMap subscribe(QLocalSocket *socket, const QCborMap& command);
+    void watchEntries();
+    void watchEntries(LaunchGroups *groups, const QString& prefix);
+    void publish(const QString& name, QCborMap event, bool isOutput = false);
+    void flush(QLocalSocket *socket);
+
+    struct Subscriber {
+        QSet<QString> names;
+        bool output;
+        int queueLimit;
+        QQueue<QByteArray> queue;
+        quint64 dropped;
+        bool droppedNoticePending;
+    };
+
+    struct Source {
+        QString prefix;
+        LaunchGroups *groups;
+        LauncherEngine *engine;
+    };
+
+    QVector<Source> sources;
+    QHash<QLocalSocket *, QByteArray> buffers;
+    QHash<QLocalSocket *, Subscriber> subscribers;
+    QHash<QLocalSocket *, QTimer *> idleTimers;
+    QLocalSocket *requester;
+    bool watching;
+};
+
+#endif // CONTROLSERVER_H
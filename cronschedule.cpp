@@ -0,0 +1,107 @@
+#include "cronschedule.h"
+
+#include <QStringList>
+
+// Enough to find the next match of any valid expression (Feb 29 on a
+// Monday is the worst case)
+constexpr auto MAX_SEARCH_STEPS = 100000;
+
+static bool parseField(const QString& field, int min, int max, quint64 *mask)
+{
+    *mask = 0;
+    const auto parts = field.split(',');
+    for (const auto& part: parts) {
+        auto range = part.section('/', 0, 0);
+        auto stepText = part.section('/', 1);
+        int step = 1;
+        if (!stepText.isEmpty()) {
+            bool ok = false;
+            step = stepText.toInt(&ok);
+            if (!ok || step <= 0)
+                return false;
+        }
+        int from = min;
+        int to = max;
+        if (range != "*") {
+            bool ok1 = false;
+            bool ok2 = true;
+            from = range.section('-', 0, 0).toInt(&ok1);
+            if (range.contains('-'))
+                to = range.section('-', 1).toInt(&ok2);
+            else if (stepText.isEmpty())
+                to = from;
+            if (!ok1 || !ok2 || from < min || to > max || from > to)
+                return false;
+        }
+        for (int v = from; v <= to; v += step)
+            *mask |= quint64(1) << v;
+    }
+    return *mask != 0;
+}
+
+CronSchedule CronSchedule::parse(const QString &spec, bool *ok)
+{
+    CronSchedule c;
+    const auto fields = spec.simplified().split(' ');
+    quint64 m[5];
+    c.valid = fields.size() == 5
+            && parseField(fields.at(0), 0, 59, &m[0])
+            && parseField(fields.at(1), 0, 23, &m[1])
+            && parseField(fields.at(2), 1, 31, &m[2])
+            && parseField(fields.at(3), 1, 12, &m[3])
+            && parseField(fields.at(4), 0, 7, &m[4]);
+    if (c.valid) {
+        c.minutes = m[0];
+        c.hours = quint32(m[1]);
+        c.days = quint32(m[2]);
+        c.months = quint32(m[3]);
+        // 7 is also sunday
+        c.weekdays = quint32(m[4] | (m[4] >> 7));
+        // as in vixie cron a field starting with "*" ("*/2" too) does not
+        // restrict the day
+        c.anyDay = fields.at(2).startsWith('*');
+        c.anyWeekday = fields.at(4).startsWith('*');
+    }
+    if (ok)
+        *ok = c.valid;
+    return c;
+}
+
+bool CronSchedule::dayMatches(const QDate &d) const
+{
+    bool dom = days & (quint32(1) << d.day());
+    bool dow = weekdays & (quint32(1) << (d.dayOfWeek() % 7));
+    // as in cron, a restricted day of month and day of week are OR'ed
+    if (anyDay || anyWeekday)
+        return dom && dow;
+    return dom || dow;
+}
+
+QDateTime CronSchedule::next(const QDateTime &after) const
+{
+    if (!valid)
+        return {};
+    auto t = QDateTime{after.date(), QTime{after.time().hour(), after.time().minute()}}.addSecs(60);
+    for (int i = 0; i < MAX_SEARCH_STEPS; i++) {
+        auto d = t.date();
+        auto tm = t.time();
+        if (!(months & (quint32(1) << d.month()))) {
+            t = QDateTime{QDate{d.year(), d.month(), 1}.addMonths(1), QTime{0, 0}};
+            continue;
+        }
+        if (!dayMatches(d)) {
+            t = QDateTime{d.addDays(1), QTime{0, 0}};
+            continue;
+        }
+        if (!(hours & (quint32(1) << tm.hour()))) {
+            t = QDateTime{d, QTime{tm.hour(), 0}}.addSecs(3600);
+            continue;
+        }
+        if (!(minutes & (quint64(1) << tm.minute()))) {
+            t = t.addSecs(60);
+            continue;
+        }
+        return t;
+    }
+    return {};
+}
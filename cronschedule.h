@@ -0,0 +1,29 @@
+#ifndef CRONSCHEDULE_H
+#define CRONSCHEDULE_H
+
+#include <QDateTime>
+
+// Classic five field cron expression: minute hour day-of-month month
+// day-of-week, each field accepting *, lists, ranges and /steps.
+class CronSchedule
+{
+public:
+    static CronSchedule parse(const QString& spec, bool *ok = nullptr);
+
+    bool isValid() const { return valid; }
+    QDateTime next(const QDateTime& after) const;
+
+private:
+    bool dayMatches(const QDate& d) const;
+
+    quint64 minutes = 0;
+    quint32 hours = 0;
+    quint32 days = 0;
+    quint32 months = 0;
+    quint32 weekdays = 0;
+    bool anyDay = false;
+    bool anyWeekday = false;
+    bool valid = false;
+};
+
+#endif // CRONSCHEDULE_H
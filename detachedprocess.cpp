@@ -0,0 +1,306 @@
+#include "detachedprocess.h"
+#include "childregistry.h"
+
+#include <QFile>
+#include <QFileSystemWatcher>
+#include <QSocketNotifier>
+#include <QTimer>
+
+#include <QtDebug>
+
+#include <cerrno>
+#include <csignal>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+constexpr auto CHILD_POLL_INTERVAL = 1000;
+// Output replayed into the log view when attaching to a running child
+constexpr auto REPLAY_BYTES = 1024 * 1024;
+
+// Start time of pid in clock ticks since boot (0 when unknown), which
+// tells a process apart from a later one that reused its pid
+static quint64 processStartTime(qint64 pid, char *state = nullptr)
+{
+#ifdef Q_OS_LINUX
+    QFile f{QString{"/proc/%1/stat"}.arg(pid)};
+    if (!f.open(QFile::ReadOnly))
+        return 0;
+    auto stat = f.readAll();
+    // the command name may contain spaces and parentheses
+    auto fields = stat.mid(stat.lastIndexOf(')') + 2).split(' ');
+    if (fields.size() < 20)
+        return 0;
+    if (state)
+        *state = fields.at(0).at(0);
+    // field 22, counted from the state which is field 3
+    return fields.at(19).toULongLong();
+#else
+    Q_UNUSED(pid)
+    Q_UNUSED(state)
+    return 0;
+#endif
+}
+
+static int openPidFd(qint64 pid)
+{
+#if defined(Q_OS_LINUX) && defined(SYS_pidfd_open)
+    return int(::syscall(SYS_pidfd_open, pid_t(pid), 0));
+#else
+    Q_UNUSED(pid)
+    return -1;
+#endif
+}
+
+// Through the pidfd when there is one, which cannot hit a process that
+// reused the pid
+static bool sendSignal(int pidFd, qint64 pid, int sig)
+{
+#if defined(Q_OS_LINUX) && defined(SYS_pidfd_send_signal)
+    if (pidFd != -1)
+        return ::syscall(SYS_pidfd_send_signal, pidFd, sig, nullptr, 0) == 0;
+#else
+    Q_UNUSED(pidFd)
+#endif
+    return ::kill(pid_t(pid), sig) == 0;
+}
+
+DetachedProcess::DetachedProcess(QObject *parent)
+    : LaunchProcess{parent},
+      registry{nullptr},
+      currentState{QProcess::NotRunning},
+      pid{0},
+      startTime{0},
+      childFd{-1},
+      childNotifier{nullptr},
+      childPoll{new QTimer{this}},
+      logWatcher{new QFileSystemWatcher{this}},
+      stdoutLog{nullptr},
+      stderrLog{nullptr}
+{
+    childPoll->setInterval(CHILD_POLL_INTERVAL);
+    connect(childPoll, &QTimer::timeout, this, &DetachedProcess::checkChild);
+    connect(logWatcher, &QFileSystemWatcher::fileChanged, this, &DetachedProcess::readLogs);
+}
+
+DetachedProcess::~DetachedProcess()
+{
+    detach();
+}
+
+void DetachedProcess::setChildRegistry(ChildRegistry *r, const QString &k)
+{
+    registry = r;
+    key = k;
+    if (!registry->contains(key) || currentState != QProcess::NotRunning)
+        return;
+    auto c = registry->child(key);
+    // opened before checking the start time: once the check passes the
+    // pidfd is known to refer to our child, even if it exits meanwhile
+    auto fd = openPidFd(c.pid);
+    if (c.startTime == 0 || processStartTime(c.pid) != c.startTime) {
+        qDebug() << key << "exited while the launcher was not running";
+        if (fd != -1)
+            ::close(fd);
+        registry->remove(key);
+        return;
+    }
+    attach(c.pid, fd, c.startTime, c.stdoutLog, c.stderrLog, REPLAY_BYTES);
+    qDebug() << "reattached to" << key << "pid" << pid;
+    setState(QProcess::Running);
+    emit started();
+}
+
+void DetachedProcess::setWorkingDirectory(const QString &dir)
+{
+    workingDirectory = dir;
+}
+
+void DetachedProcess::setProcessEnvironment(const QProcessEnvironment &env)
+{
+    environment = env;
+}
+
+QProcess::ProcessState DetachedProcess::state() const
+{
+    return currentState;
+}
+
+qint64 DetachedProcess::processId() const
+{
+    return pid;
+}
+
+QByteArray DetachedProcess::readAllStandardOutput()
+{
+    QByteArray r;
+    r.swap(stdoutBuffer);
+    return r;
+}
+
+QByteArray DetachedProcess::readAllStandardError()
+{
+    QByteArray r;
+    r.swap(stderrBuffer);
+    return r;
+}
+
+void DetachedProcess::start(const QString &program, const QStringList &arguments)
+{
+    if (currentState != QProcess::NotRunning) {
+        qWarning("DetachedProcess::start: process is already running");
+        return;
+    }
+    if (!registry) {
+        qWarning("DetachedProcess::start: no child registry");
+        emit errorOccurred(QProcess::FailedToStart);
+        return;
+    }
+    beginSpawnMeasure();
+    setState(QProcess::Starting);
+
+    auto stdoutFile = registry->logFile(key, "stdout");
+    auto stderrFile = registry->logFile(key, "stderr");
+    QProcess p;
+    p.setProgram(program);
+    p.setArguments(arguments);
+    p.setWorkingDirectory(workingDirectory);
+    if (!environment.isEmpty())
+        p.setProcessEnvironment(environment);
+    p.setStandardOutputFile(stdoutFile);
+    p.setStandardErrorFile(stderrFile);
+    qint64 child = 0;
+    if (!p.startDetached(&child)) {
+        qDebug() << "start" << program << "failed:" << p.errorString();
+        emit errorOccurred(QProcess::FailedToStart);
+        setState(QProcess::NotRunning);
+        return;
+    }
+    markExec();
+
+    auto fd = openPidFd(child);
+    auto childStartTime = processStartTime(child);
+    registry->add(key, ChildRegistry::Child{child, childStartTime, stdoutFile, stderrFile});
+    // a child that is already gone is noticed by the first check
+    attach(child, fd, childStartTime, stdoutFile, stderrFile, 0);
+
+    endSpawnMeasure("detached");
+    setState(QProcess::Running);
+    emit started();
+}
+
+void DetachedProcess::terminate()
+{
+    if (pid > 0)
+        sendSignal(childFd, pid, SIGTERM);
+}
+
+void DetachedProcess::attach(qint64 child, int pidFd, quint64 childStartTime,
+                             const QString &stdoutFile, const QString &stderrFile, qint64 replay)
+{
+    pid = child;
+    childFd = pidFd;
+    startTime = childStartTime;
+
+    char state = 0;
+    processStartTime(pid, &state);
+    // paused with SIGSTOP by the previous launcher instance, which stopped
+    // the whole process group (a cgroup freeze is undone by CgroupFreezer)
+    if (state == 'T') {
+        auto group = ::getpgid(pid_t(pid));
+        if (group <= 0 || group == ::getpgrp() || ::killpg(group, SIGCONT) != 0)
+            sendSignal(childFd, pid, SIGCONT);
+    }
+
+    stdoutLog = new QFile{stdoutFile, this};
+    stderrLog = new QFile{stderrFile, this};
+    for (auto log: {stdoutLog, stderrLog}) {
+        if (!log->open(QFile::ReadOnly | QFile::Unbuffered)) {
+            qDebug() << "cannot read" << log->fileName() << log->errorString();
+            continue;
+        }
+        if (replay > 0 && log->size() > replay)
+            log->seek(log->size() - replay);
+        logWatcher->addPath(log->fileName());
+    }
+
+    if (childFd != -1) {
+        childNotifier = new QSocketNotifier{childFd, QSocketNotifier::Read, this};
+        connect(childNotifier, SIGNAL(activated(int)), SLOT(childExited()));
+    } else {
+        childPoll->start();
+    }
+    // output written before we were watching
+    QTimer::singleShot(0, this, &DetachedProcess::readLogs);
+}
+
+void DetachedProcess::checkChild()
+{
+    if (pid <= 0)
+        return;
+    char state = 0;
+    auto alive = ::kill(pid_t(pid), 0) == 0 || errno == EPERM;
+    if (alive && startTime != 0)
+        alive = processStartTime(pid, &state) == startTime && state != 'Z';
+    if (!alive)
+        childExited();
+}
+
+void DetachedProcess::childExited()
+{
+    if (pid <= 0)
+        return;
+    readLogs();
+    detach();
+    pid = 0;
+    startTime = 0;
+    if (registry)
+        registry->remove(key);
+    setState(QProcess::NotRunning);
+    // the exit status of a process that is not our child is not available
+    emit finished(0, QProcess::NormalExit);
+}
+
+void DetachedProcess::readLogs()
+{
+    readLog(stdoutLog, stdoutBuffer, false);
+    readLog(stderrLog, stderrBuffer, true);
+}
+
+void DetachedProcess::readLog(QFile *log, QByteArray &buffer, bool isError)
+{
+    if (!log || !log->isOpen())
+        return;
+    auto data = log->readAll();
+    if (data.isEmpty())
+        return;
+    buffer.append(data);
+    if (isError)
+        emit readyReadStandardError();
+    else
+        emit readyReadStandardOutput();
+}
+
+void DetachedProcess::setState(QProcess::ProcessState newState)
+{
+    if (currentState == newState)
+        return;
+    currentState = newState;
+    emit stateChanged(newState);
+}
+
+void DetachedProcess::detach()
+{
+    childPoll->stop();
+    delete childNotifier;
+    childNotifier = nullptr;
+    if (childFd != -1) {
+        ::close(childFd);
+        childFd = -1;
+    }
+    if (!logWatcher->files().isEmpty())
+        logWatcher->removePaths(logWatcher->files());
+    delete stdoutLog;
+    delete stderrLog;
+    stdoutLog = nullptr;
+    stderrLog = nullptr;
+}
@@ -0,0 +1,70 @@
+#ifndef DETACHEDPROCESS_H
+#define DETACHEDPROCESS_H
+
+#include "launchprocess.h"
+
+#include <QProcessEnvironment>
+
+class QFile;
+class QFileSystemWatcher;
+class QSocketNotifier;
+class QTimer;
+
+// Backend for applications that must survive the launcher: the child is
+// started detached with its output going to log files, which are tailed
+// instead of pipes, and is recorded in the ChildRegistry so the next
+// launcher instance can attach to it again.
+class DetachedProcess : public LaunchProcess
+{
+    Q_OBJECT
+
+public:
+    explicit DetachedProcess(QObject *parent = nullptr);
+    // Leaves the child running
+    ~DetachedProcess() override;
+
+    void setChildRegistry(ChildRegistry *registry, const QString& key) override;
+
+    void setWorkingDirectory(const QString& dir) override;
+    void setProcessEnvironment(const QProcessEnvironment& env) override;
+
+    QProcess::ProcessState state() const override;
+    qint64 processId() const override;
+
+    QByteArray readAllStandardOutput() override;
+    QByteArray readAllStandardError() override;
+
+public slots:
+    void start(const QString& program, const QStringList& arguments) override;
+    void terminate() override;
+
+private slots:
+    void checkChild();
+    void childExited();
+    void readLogs();
+
+private:
+    void attach(qint64 child, int pidFd, quint64 childStartTime,
+                const QString& stdoutFile, const QString& stderrFile, qint64 replay);
+    void setState(QProcess::ProcessState newState);
+    void readLog(QFile *log, QByteArray& buffer, bool isError);
+    void detach();
+
+    ChildRegistry *registry;
+    QString key;
+    QString workingDirectory;
+    QProcessEnvironment environment;
+    QProcess::ProcessState currentState;
+    qint64 pid;
+    quint64 startTime;
+    int childFd;
+    QSocketNotifier *childNotifier;
+    QTimer *childPoll;
+    QFileSystemWatcher *logWatcher;
+    QFile *stdoutLog;
+    QFile *stderrLog;
+    QByteArray stdoutBuffer;
+    QByteArray stderrBuffer;
+};
+
+#endif // DETACHEDPROCESS_H
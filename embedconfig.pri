@@ -0,0 +1,33 @@
+# Embeds JSON configurations in the binary, validated and compiled into
+# constexpr data at build time (see embeddedconfig.h). Usage:
+#
+#     include(embedconfig.pri)
+#     embedConfig(site-config.json, site-config.inc)
+#
+# qmake itself wraps the JSON file in a C++ raw string literal and writes
+# it to <output> in the build directory, so no shell or other tool is
+# needed on any host. Editing the JSON file makes the build run qmake
+# again, which regenerates <output> and rebuilds what includes it.
+
+HEADERS *= $$PWD/embeddedconfig.h
+# where the generated files are written
+INCLUDEPATH *= $$OUT_PWD
+
+defineTest(embedConfig) {
+    input = $$absolute_path($$1, $$_PRO_FILE_PWD_)
+    output = $$absolute_path($$2, $$OUT_PWD)
+    !exists($$input): error("embedConfig: $$input does not exist")
+
+    # a delimiter inside the text ends the literal early and the
+    # EMBEDDED_CONFIG check rejects what is left
+    contents = R\"__json__(
+    contents += $$cat($$input, lines)
+    contents += )__json__\"
+    !write_file($$output, contents): error("embedConfig: cannot write $$output")
+
+    QMAKE_INTERNAL_INCLUDED_FILES += $$input
+    DISTFILES += $$input
+    export(QMAKE_INTERNAL_INCLUDED_FILES)
+    export(DISTFILES)
+    return(true)
+}
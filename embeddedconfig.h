@@ -0,0 +1,377 @@
+#ifndef EMBEDDEDCONFIG_H
+#define EMBEDDEDCONFIG_H
+
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QJsonValue>
+
+#include <array>
+#include <cstddef>
+#include <string_view>
+
+// JSON configurations compiled into the binary. The compiler parses the
+// text into a flat array of nodes: a broken document fails the build, and
+// loading it at run time only builds the QJsonObject, without any text
+// scanning. The text comes from a file wrapped by embedConfig() in
+// embedconfig.pri:
+//
+//     constexpr char SITE_CONFIG_TEXT[] =
+//     #include "site-config.inc"
+//     ;
+//     EMBEDDED_CONFIG(SITE_CONFIG, SITE_CONFIG_TEXT);
+//     ...
+//     auto config = SITE_CONFIG.toJsonObject();
+namespace EmbeddedConfig {
+
+enum class Type { Null, False, True, Number, String, Array, Object };
+
+// Nodes are stored in document order; arrays and objects are followed by
+// their count children, each carrying its key when inside an object
+struct Node {
+    Type type = Type::Null;
+    std::size_t keyOffset = 0;
+    std::size_t keyLength = 0;
+    std::size_t offset = 0;
+    std::size_t length = 0;
+    std::size_t count = 0;
+    double number = 0;
+};
+
+// Without output arrays it only validates and measures the document
+class Parser
+{
+public:
+    constexpr Parser(std::string_view text, Node *nodes = nullptr, char *strings = nullptr)
+        : text{text}, nodes{nodes}, strings{strings}
+    {
+    }
+
+    constexpr bool parse()
+    {
+        skipSpace();
+        valid = value(0, 0);
+        skipSpace();
+        valid = valid && pos == text.size();
+        return valid;
+    }
+
+    bool valid = false;
+    Type rootType = Type::Null;
+    std::size_t nodeCount = 0;
+    std::size_t stringBytes = 0;
+
+private:
+    constexpr bool peek(char c) const { return pos < text.size() && text[pos] == c; }
+
+    constexpr void skipSpace()
+    {
+        while (peek(' ') || peek('\t') || peek('\n') || peek('\r'))
+            pos++;
+    }
+
+    constexpr bool literal(std::string_view word)
+    {
+        if (text.substr(pos, word.size()) != word)
+            return false;
+        pos += word.size();
+        return true;
+    }
+
+    constexpr void put(char c)
+    {
+        if (strings)
+            strings[stringBytes] = c;
+        stringBytes++;
+    }
+
+    constexpr void putUtf8(unsigned long code)
+    {
+        if (code < 0x80) {
+            put(char(code));
+        } else if (code < 0x800) {
+            put(char(0xc0 | (code >> 6)));
+            put(char(0x80 | (code & 0x3f)));
+        } else if (code < 0x10000) {
+            put(char(0xe0 | (code >> 12)));
+            put(char(0x80 | ((code >> 6) & 0x3f)));
+            put(char(0x80 | (code & 0x3f)));
+        } else {
+            put(char(0xf0 | (code >> 18)));
+            put(char(0x80 | ((code >> 12) & 0x3f)));
+            put(char(0x80 | ((code >> 6) & 0x3f)));
+            put(char(0x80 | (code & 0x3f)));
+        }
+    }
+
+    constexpr bool hex4(unsigned long& code)
+    {
+        code = 0;
+        for (int i = 0; i < 4; i++, pos++) {
+            if (pos >= text.size())
+                return false;
+            char c = text[pos];
+            code <<= 4;
+            if (c >= '0' && c <= '9')
+                code |= (unsigned long)(c - '0');
+            else if (c >= 'a' && c <= 'f')
+                code |= (unsigned long)(c - 'a' + 10);
+            else if (c >= 'A' && c <= 'F')
+                code |= (unsigned long)(c - 'A' + 10);
+            else
+                return false;
+        }
+        return true;
+    }
+
+    constexpr bool string(std::size_t& offset, std::size_t& length)
+    {
+        pos++; // opening quote
+        offset = stringBytes;
+        for (;;) {
+            if (pos >= text.size())
+                return false;
+            char c = text[pos++];
+            if (c == '"')
+                break;
+            if ((unsigned char)c < 0x20)
+                return false;
+            if (c != '\\') {
+                put(c);
+                continue;
+            }
+            if (pos >= text.size())
+                return false;
+            switch (text[pos++]) {
+            case '"': put('"'); break;
+            case '\\': put('\\'); break;
+            case '/': put('/'); break;
+            case 'b': put('\b'); break;
+            case 'f': put('\f'); break;
+            case 'n': put('\n'); break;
+            case 'r': put('\r'); break;
+            case 't': put('\t'); break;
+            case 'u': {
+                unsigned long code = 0;
+                if (!hex4(code))
+                    return false;
+                if (code >= 0xd800 && code < 0xdc00) {
+                    // surrogate pair
+                    unsigned long low = 0;
+                    if (!literal("\\u") || !hex4(low) || low < 0xdc00 || low >= 0xe000)
+                        return false;
+                    code = 0x10000 + ((code - 0xd800) << 10) + (low - 0xdc00);
+                } else if (code >= 0xdc00 && code < 0xe000) {
+                    return false;
+                }
+                putUtf8(code);
+                break;
+            }
+            default:
+                return false;
+            }
+        }
+        length = stringBytes - offset;
+        return true;
+    }
+
+    constexpr bool digits(double& v, int& count)
+    {
+        count = 0;
+        while (pos < text.size() && text[pos] >= '0' && text[pos] <= '9') {
+            v = v * 10 + (text[pos++] - '0');
+            count++;
+        }
+        return count > 0;
+    }
+
+    constexpr bool number(double& v)
+    {
+        bool negative = peek('-');
+        if (negative)
+            pos++;
+        int count = 0;
+        if (peek('0')) {
+            pos++;
+        } else if (!digits(v, count)) {
+            return false;
+        }
+        if (peek('.')) {
+            pos++;
+            double fraction = 0;
+            if (!digits(fraction, count))
+                return false;
+            for (int i = 0; i < count; i++)
+                fraction /= 10;
+            v += fraction;
+        }
+        if (peek('e') || peek('E')) {
+            pos++;
+            bool negativeExponent = peek('-');
+            if (negativeExponent || peek('+'))
+                pos++;
+            double exponent = 0;
+            if (!digits(exponent, count))
+                return false;
+            for (int i = 0; i < int(exponent); i++)
+                v = negativeExponent? v / 10 : v * 10;
+        }
+        if (negative)
+            v = -v;
+        return true;
+    }
+
+    constexpr bool value(std::size_t keyOffset, std::size_t keyLength)
+    {
+        std::size_t index = nodeCount++;
+        Node node;
+        node.keyOffset = keyOffset;
+        node.keyLength = keyLength;
+        if (pos >= text.size())
+            return false;
+        char c = text[pos];
+        if (c == '{' || c == '[') {
+            bool isObject = c == '{';
+            char close = isObject? '}' : ']';
+            node.type = isObject? Type::Object : Type::Array;
+            pos++;
+            skipSpace();
+            if (peek(close)) {
+                pos++;
+            } else {
+                for (;;) {
+                    skipSpace();
+                    std::size_t childKeyOffset = 0;
+                    std::size_t childKeyLength = 0;
+                    if (isObject) {
+                        if (!peek('"') || !string(childKeyOffset, childKeyLength))
+                            return false;
+                        skipSpace();
+                        if (!peek(':'))
+                            return false;
+                        pos++;
+                        skipSpace();
+                    }
+                    if (!value(childKeyOffset, childKeyLength))
+                        return false;
+                    node.count++;
+                    skipSpace();
+                    if (peek(',')) {
+                        pos++;
+                        continue;
+                    }
+                    if (!peek(close))
+                        return false;
+                    pos++;
+                    break;
+                }
+            }
+        } else if (c == '"') {
+            node.type = Type::String;
+            if (!string(node.offset, node.length))
+                return false;
+        } else if (c == '-' || (c >= '0' && c <= '9')) {
+            node.type = Type::Number;
+            if (!number(node.number))
+                return false;
+        } else if (literal("true")) {
+            node.type = Type::True;
+        } else if (literal("false")) {
+            node.type = Type::False;
+        } else if (!literal("null")) {
+            return false;
+        }
+        if (index == 0)
+            rootType = node.type;
+        if (nodes)
+            nodes[index] = node;
+        return true;
+    }
+
+    std::string_view text;
+    Node *nodes;
+    char *strings;
+    std::size_t pos = 0;
+};
+
+constexpr Parser measure(std::string_view text)
+{
+    Parser p{text};
+    p.parse();
+    return p;
+}
+
+constexpr bool isValidConfig(std::string_view text)
+{
+    auto p = measure(text);
+    return p.valid && p.rootType == Type::Object;
+}
+
+template <std::size_t Nodes, std::size_t Chars>
+struct Document {
+    std::array<Node, Nodes> nodes{};
+    std::array<char, Chars> strings{};
+
+    QJsonObject toJsonObject() const
+    {
+        std::size_t i = 0;
+        return toJson(i).toObject();
+    }
+
+private:
+    QString text(std::size_t offset, std::size_t length) const
+    {
+        return QString::fromUtf8(strings.data() + offset, int(length));
+    }
+
+    QJsonValue toJson(std::size_t& i) const
+    {
+        const auto& node = nodes[i++];
+        switch (node.type) {
+        case Type::Null:
+            return QJsonValue{};
+        case Type::False:
+            return false;
+        case Type::True:
+            return true;
+        case Type::Number:
+            return node.number;
+        case Type::String:
+            return text(node.offset, node.length);
+        case Type::Array: {
+            QJsonArray a;
+            for (std::size_t c = 0; c < node.count; c++)
+                a.append(toJson(i));
+            return a;
+        }
+        case Type::Object: {
+            QJsonObject o;
+            for (std::size_t c = 0; c < node.count; c++) {
+                auto key = text(nodes[i].keyOffset, nodes[i].keyLength);
+                o.insert(key, toJson(i));
+            }
+            return o;
+        }
+        }
+        return {};
+    }
+};
+
+template <std::size_t Nodes, std::size_t Chars>
+constexpr Document<Nodes, Chars> parse(std::string_view text)
+{
+    Document<Nodes, Chars> d;
+    Parser p{text, d.nodes.data(), d.strings.data()};
+    p.parse();
+    return d;
+}
+
+} // namespace EmbeddedConfig
+
+// Declares name as the compiled form of text, a string literal holding a
+// JSON object; anything else stops the build
+#define EMBEDDED_CONFIG(name, text) \
+    static_assert(EmbeddedConfig::isValidConfig(text), #text " is not a valid JSON configuration"); \
+    constexpr auto name = EmbeddedConfig::parse<EmbeddedConfig::measure(text).nodeCount, \
+                                                EmbeddedConfig::measure(text).stringBytes>(text)
+
+#endif // EMBEDDEDCONFIG_H
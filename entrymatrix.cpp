@@ -0,0 +1,118 @@
+#include "entrymatrix.h"
+
+#include <QJsonArray>
+
+#include <QtDebug>
+
+constexpr auto MAX_INSTANCES = 10000;
+
+QString EntryMatrix::Param::value(int index) const
+{
+    return values.isEmpty()? QString::number(from + index) : values.at(index);
+}
+
+EntryMatrix::EntryMatrix(const QJsonObject &e)
+    : entry{e},
+      count{1}
+{
+    entry.remove("matrix");
+    auto matrix = e.value("matrix").toObject();
+    for (auto it = matrix.constBegin(); it != matrix.constEnd(); ++it) {
+        Param p{it.key(), {}, 0, 0};
+        if (it.value().isArray()) {
+            const auto values = it.value().toArray();
+            for (const auto& v: values)
+                p.values.append(v.isString()? v.toString() : v.toVariant().toString());
+            p.count = p.values.size();
+        } else {
+            // {"from": 8000, "to": 8099}
+            auto range = it.value().toObject();
+            p.from = qint64(range.value("from").toDouble());
+            p.count = int(qMax<qint64>(qint64(range.value("to").toDouble()) - p.from + 1, 0));
+        }
+        if (qint64(count) * p.count > MAX_INSTANCES) {
+            qWarning() << "matrix of" << e.value("text").toString() << "limited to" << MAX_INSTANCES << "instances";
+            p.count = MAX_INSTANCES / count;
+            p.values = p.values.mid(0, p.count);
+        }
+        count *= p.count;
+        params.append(p);
+    }
+}
+
+QJsonObject EntryMatrix::instance(int index) const
+{
+    QVector<QString> values(params.size());
+    // the last parameter varies fastest
+    for (int p = params.size() - 1; p >= 0; p--) {
+        const auto& param = params.at(p);
+        values[p] = param.value(index % param.count);
+        index /= param.count;
+    }
+    return expand(entry, values).toObject();
+}
+
+EntryMatrix::Template EntryMatrix::compile(const QString &s) const
+{
+    Template t;
+    int literal = 0;
+    int i = 0;
+    while ((i = s.indexOf("${", i)) >= 0) {
+        auto end = s.indexOf('}', i + 2);
+        if (end < 0)
+            break;
+        auto name = s.mid(i + 2, end - i - 2);
+        int param = 0;
+        while (param < params.size() && params.at(param).name != name)
+            param++;
+        // not a parameter: left for the environment expansion
+        if (param == params.size()) {
+            i = end + 1;
+            continue;
+        }
+        t.append(Segment{s.mid(literal, i - literal), -1});
+        t.append(Segment{{}, param});
+        literal = i = end + 1;
+    }
+    if (!t.isEmpty())
+        t.append(Segment{s.mid(literal), -1});
+    return t;
+}
+
+QString EntryMatrix::render(const QString &s, const QVector<QString> &values) const
+{
+    auto it = compiled.constFind(s);
+    if (it == compiled.constEnd())
+        it = compiled.insert(s, compile(s));
+    // no parameter: every instance shares the same string
+    if (it->isEmpty())
+        return s;
+    QString r;
+    for (const auto& seg: *it)
+        r.append(seg.param < 0? seg.text : values.at(seg.param));
+    return r;
+}
+
+QJsonValue EntryMatrix::expand(const QJsonValue &v, const QVector<QString> &values) const
+{
+    switch (v.type()) {
+    case QJsonValue::String:
+        return render(v.toString(), values);
+    case QJsonValue::Array: {
+        QJsonArray a;
+        const auto items = v.toArray();
+        for (const auto& x: items)
+            a.append(expand(x, values));
+        return a;
+    }
+    case QJsonValue::Object: {
+        QJsonObject o;
+        const auto obj = v.toObject();
+        for (auto it = obj.constBegin(); it != obj.constEnd(); ++it)
+            o.insert(it.key(), expand(it.value(), values));
+        return o;
+    }
+    default:
+        return v;
+    }
+}
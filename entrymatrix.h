@@ -0,0 +1,51 @@
+#ifndef ENTRYMATRIX_H
+#define ENTRYMATRIX_H
+
+#include <QHash>
+#include <QJsonObject>
+#include <QStringList>
+#include <QVector>
+
+// An application entry with a "matrix" of parameters, standing for one
+// entry per combination of parameter values. Instances are produced one
+// at a time from the shared template: "${param}" in any string of the
+// entry is replaced by the value of the parameter for that instance.
+class EntryMatrix
+{
+public:
+    explicit EntryMatrix(const QJsonObject& entry);
+
+    int size() const { return count; }
+    QJsonObject instance(int index) const;
+    // Whether s differs between instances
+    bool varies(const QString& s) const { return !compile(s).isEmpty(); }
+
+private:
+    struct Param {
+        QString name;
+        // either explicit values or the integer range from, from + 1...
+        QStringList values;
+        qint64 from;
+        int count;
+
+        QString value(int index) const;
+    };
+
+    struct Segment {
+        QString text;
+        int param;
+    };
+    using Template = QVector<Segment>;
+
+    Template compile(const QString& s) const;
+    QString render(const QString& s, const QVector<QString>& values) const;
+    QJsonValue expand(const QJsonValue& v, const QVector<QString>& values) const;
+
+    QJsonObject entry;
+    QVector<Param> params;
+    int count;
+    // strings are compiled once, whatever the number of instances
+    mutable QHash<QString, Template> compiled;
+};
+
+#endif // ENTRYMATRIX_H
@@ -65,19 +65,21 @@ FlowLayout::FlowLayout(int margin, int hSpacing, int vSpacing)
 }
 //! [1]
 
+constexpr auto MAX_CACHED_HEIGHTS = 64;
+
 //! [2]
 FlowLayout::~FlowLayout()
 {
-    QLayoutItem *item;
-    while ((item = FlowLayout::takeAt(0)))
-        delete item;
+    qDeleteAll(itemList);
 }
 //! [2]
 
 //! [3]
 void FlowLayout::addItem(QLayoutItem *item)
 {
+    firstChanged = qMin(firstChanged, itemList.size());
     itemList.append(item);
+    invalidateCache();
 }
 //! [3]
 
@@ -114,13 +116,66 @@ QLayoutItem *FlowLayout::itemAt(int index) const
 
 QLayoutItem *FlowLayout::takeAt(int index)
 {
-    if (index >= 0 && index < itemList.size())
-        return itemList.takeAt(index);
-    else
+    if (index >= 0 && index < itemList.size()) {
+        firstChanged = qMin(firstChanged, index);
+        auto item = itemList.takeAt(index);
+        invalidateCache();
+        return item;
+    } else
         return 0;
 }
 //! [5]
 
+// Called for a child's updateGeometry() or show/hide as well as for style
+// and margin changes. firstChanged is left alone: updateCache() finds the
+// first item whose hint changed (a hidden widget has an empty hint), a new
+// spacing restarts from the first item and new margins change the
+// rectangle doLayout() compares with the last pass.
+void FlowLayout::invalidate()
+{
+    invalidateCache();
+}
+
+// addItem() and takeAt() know the first item that moves
+void FlowLayout::invalidateCache()
+{
+    cacheValid = false;
+    heights.clear();
+    QLayout::invalidate();
+}
+
+// Asks every item for its size hint once per invalidation, and moves
+// firstChanged back to the first item whose hint differs
+void FlowLayout::updateCache() const
+{
+    if (cacheValid)
+        return;
+    auto style = parentWidget()? parentWidget()->style() : QApplication::style();
+    auto x = horizontalSpacing();
+    if (x == -1)
+        x = style->layoutSpacing(QSizePolicy::PushButton, QSizePolicy::PushButton, Qt::Horizontal);
+    auto y = verticalSpacing();
+    if (y == -1)
+        y = style->layoutSpacing(QSizePolicy::PushButton, QSizePolicy::PushButton, Qt::Vertical);
+    if (x != spaceX || y != spaceY)
+        firstChanged = 0;
+    spaceX = x;
+    spaceY = y;
+
+    QVector<QSize> updated;
+    updated.reserve(itemList.size());
+    minSize = QSize{};
+    for (int i = 0; i < itemList.size(); i++) {
+        auto item = itemList.at(i);
+        updated.append(item->sizeHint());
+        minSize = minSize.expandedTo(item->minimumSize());
+        if (i < firstChanged && (i >= hints.size() || hints.at(i) != updated.at(i)))
+            firstChanged = i;
+    }
+    hints = updated;
+    cacheValid = true;
+}
+
 //! [6]
 Qt::Orientations FlowLayout::expandingDirections() const
 {
@@ -136,7 +191,14 @@ bool FlowLayout::hasHeightForWidth() const
 
 int FlowLayout::heightForWidth(int width) const
 {
+    auto it = heights.constFind(width);
+    if (it != heights.constEnd())
+        return *it;
+    // a resize asks for many widths: keep the recent ones only
+    if (heights.size() >= MAX_CACHED_HEIGHTS)
+        heights.clear();
     int height = doLayout(QRect(0, 0, width, 0), true);
+    heights.insert(width, height);
     return height;
 }
 //! [7]
@@ -155,54 +217,62 @@ QSize FlowLayout::sizeHint() const
 
 QSize FlowLayout::minimumSize() const
 {
-    QSize size;
-    QLayoutItem *item;
-    foreach (item, itemList)
-        size = size.expandedTo(item->minimumSize());
-
-    size += QSize(2*margin(), 2*margin());
-    return size;
+    updateCache();
+    auto m = contentsMargins();
+    return minSize + QSize(m.left() + m.right(), m.top() + m.bottom());
 }
 //! [8]
 
 //! [9]
 int FlowLayout::doLayout(const QRect &rect, bool testOnly) const
 {
+    updateCache();
     int left, top, right, bottom;
     getContentsMargins(&left, &top, &right, &bottom);
     QRect effectiveRect = rect.adjusted(+left, +top, -right, -bottom);
     int x = effectiveRect.x();
     int y = effectiveRect.y();
     int lineHeight = 0;
+    int first = 0;
+    if (!testOnly) {
+        // the items before firstChanged stay where the last pass put them
+        if (effectiveRect == laidOut)
+            first = qMin(firstChanged, qMin(positions.size(), hints.size()));
+        positions.resize(hints.size());
+        if (first > 0) {
+            auto last = first - 1;
+            x = positions.at(last).x() + hints.at(last).width() + spaceX;
+            y = positions.at(last).y();
+            for (int i = last; i >= 0 && positions.at(i).y() == y; i--)
+                lineHeight = qMax(lineHeight, hints.at(i).height());
+        }
+    }
     //! [9]
 
     //! [10]
-    QLayoutItem *item;
-    foreach (item, itemList) {
-        QWidget *wid = item->widget();
-        int spaceX = horizontalSpacing();
-        if (spaceX == -1)
-            spaceX = wid->style()->layoutSpacing(
-                QSizePolicy::PushButton, QSizePolicy::PushButton, Qt::Horizontal);
-        int spaceY = verticalSpacing();
-        if (spaceY == -1)
-            spaceY = wid->style()->layoutSpacing(
-                QSizePolicy::PushButton, QSizePolicy::PushButton, Qt::Vertical);
+    for (int i = first; i < hints.size(); i++) {
+        const auto& hint = hints.at(i);
         //! [10]
         //! [11]
-        int nextX = x + item->sizeHint().width() + spaceX;
+        int nextX = x + hint.width() + spaceX;
         if (nextX - spaceX > effectiveRect.right() && lineHeight > 0) {
             x = effectiveRect.x();
             y = y + lineHeight + spaceY;
-            nextX = x + item->sizeHint().width() + spaceX;
+            nextX = x + hint.width() + spaceX;
             lineHeight = 0;
         }
 
-        if (!testOnly)
-            item->setGeometry(QRect(QPoint(x, y), item->sizeHint()));
+        if (!testOnly) {
+            positions[i] = QPoint(x, y);
+            itemList.at(i)->setGeometry(QRect(QPoint(x, y), hint));
+        }
 
         x = nextX;
-        lineHeight = qMax(lineHeight, item->sizeHint().height());
+        lineHeight = qMax(lineHeight, hint.height());
+    }
+    if (!testOnly) {
+        laidOut = effectiveRect;
+        firstChanged = hints.size();
     }
     return y + lineHeight - rect.y() + bottom;
 }
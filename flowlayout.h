@@ -51,10 +51,17 @@
 #ifndef FLOWLAYOUT_H
 #define FLOWLAYOUT_H
 
+#include <QHash>
 #include <QLayout>
 #include <QRect>
 #include <QStyle>
+#include <QVector>
 //! [0]
+// Size hints, spacing and minimum size are cached until the layout is
+// invalidated, heightForWidth() is memoized per width, and a pass over
+// the same rectangle with the same spacing only moves the items from the
+// first one whose size hint changed (a child resized, shown or hidden), or
+// that was added or removed, onwards.
 class FlowLayout : public QLayout
 {
 public:
@@ -74,14 +81,29 @@ public:
     void setGeometry(const QRect &rect) override;
     QSize sizeHint() const override;
     QLayoutItem *takeAt(int index) override;
+    void invalidate() override;
 
 private:
+    void invalidateCache();
+    void updateCache() const;
     int doLayout(const QRect &rect, bool testOnly) const;
     int smartSpacing(QStyle::PixelMetric pm) const;
 
     QList<QLayoutItem *> itemList;
     int m_hSpace;
     int m_vSpace;
+
+    mutable bool cacheValid = false;
+    mutable QVector<QSize> hints;
+    mutable QSize minSize;
+    mutable int spaceX = 0;
+    mutable int spaceY = 0;
+    mutable QHash<int, int> heights;
+    // positions of the last applied pass over laidOut, the rectangle inside
+    // the margins; valid before firstChanged
+    mutable QVector<QPoint> positions;
+    mutable QRect laidOut;
+    mutable int firstChanged = 0;
 };
 //! [0]
 
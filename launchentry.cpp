@@ -0,0 +1,449 @@
+#include "launchentry.h"
+#include "pathresolver.h"
+#include "launchscheduler.h"
+#include "childregistry.h"
+
+#include <QProcess>
+#include <QDir>
+#include <QTimer>
+
+#include <QtDebug>
+
+// A prefetch keeps counting as warm for this long; after that the kernel
+// may well have evicted the pages again.
+constexpr auto PREFETCH_WARM_MS = 10 * 60 * 1000;
+// Do not queue another hover prefetch while the last one is this recent
+constexpr auto PREFETCH_HOVER_MS = 60 * 1000;
+// Output kept for the control protocol "tail" command
+constexpr auto OUTPUT_TAIL_BYTES = 64 * 1024;
+
+LaunchEntry::LaunchEntry(const QString &text,
+                         const QString &iconName,
+                         const QString &path,
+                         const QString &workdir,
+                         const QProcessEnvironment &env,
+                         LaunchProcess::Backend backend,
+                         QObject *parent)
+    : QObject{parent},
+      manager{nullptr},
+      backend{backend},
+      environment{env},
+      childRegistry{nullptr},
+      label{text},
+      icon{iconName},
+      workingDirectory{workdir},
+      pathResolver{nullptr},
+      launchStats{nullptr},
+      awaitingOutput{false},
+      prefetcher{nullptr},
+      prefetchMode{Prefetcher::Off},
+      launchPrefetched{false},
+      ready{false},
+      failed{false},
+      stdoutScan{0},
+      stderrScan{0},
+      scheduler{nullptr},
+      schedulePriority{0},
+      queuePosition{0},
+      freezeReasons{0},
+      freezeWhileHidden{false},
+      idleTimer{nullptr},
+      idleInterval{0},
+      pressureAction{PressureIgnore},
+      stoppedByPressure{false},
+      restartPending{false}
+{
+    auto args = QProcess::splitCommand(path);
+    if (!args.isEmpty()) {
+        program = args.takeFirst();
+        arguments = args;
+    }
+    resolveProgram();
+}
+
+LaunchProcess *LaunchEntry::process()
+{
+    if (manager)
+        return manager;
+    manager = LaunchProcess::create(backend, this);
+    if (!workingDirectory.isEmpty())
+        manager->setWorkingDirectory(workingDirectory);
+    qDebug() << "Process" << label << "env:\n\t" << environment.toStringList();
+    manager->setProcessEnvironment(environment);
+    idleTimer = new QTimer{this};
+    idleTimer->setSingleShot(true);
+    idleTimer->setInterval(idleInterval);
+    connect(idleTimer, &QTimer::timeout, this, [this]() { freeze(FreezeWhenIdle); });
+    connect(manager, &LaunchProcess::frozenChanged, this, [this](bool frozen) {
+        if (!frozen)
+            freezeReasons = 0;
+        emit frozenChanged(frozen);
+    });
+    connect(manager, &LaunchProcess::stateChanged, this, [this](QProcess::ProcessState state) {
+        bool isStarted = state == QProcess::Running;
+        if (isStarted) {
+            recordPhase(LaunchStats::Running);
+            if (idleInterval > 0)
+                idleTimer->start();
+        } else if (state == QProcess::NotRunning) {
+            launchTimer.invalidate();
+            awaitingOutput = false;
+            idleTimer->stop();
+            if (restartPending) {
+                restartPending = false;
+                QTimer::singleShot(0, this, [this]() {
+                    start();
+                    emit restarted();
+                });
+            }
+        }
+        emit stateChange(isStarted);
+        // with a readiness probe the output decides when we are ready
+        if (!isStarted || !hasReadinessProbe())
+            setReady(isStarted);
+    });
+    connect(manager, &LaunchProcess::finished, this, [this](int exitCode, QProcess::ExitStatus status) {
+        emit exited(exitCode, status == QProcess::CrashExit);
+    });
+    connect(manager, &LaunchProcess::started, this, [this]() {
+        // stamped by the backend when it forked, not when we got here
+        auto sinceExec = manager->nsecsSinceExec();
+        if (sinceExec >= 0)
+            recordPhase(LaunchStats::Exec, sinceExec);
+    });
+    connect(manager, &LaunchProcess::readyReadStandardError, this, [this] () {
+        auto data = manager->readAllStandardError();
+        if (idleTimer->isActive())
+            idleTimer->start();
+        scanOutput(stderrScan, data);
+        appendOutput(data, true);
+    });
+    connect(manager, &LaunchProcess::readyReadStandardOutput, this, [this] () {
+        if (awaitingOutput) {
+            awaitingOutput = false;
+            recordPhase(LaunchStats::FirstOutput);
+        }
+        auto data = manager->readAllStandardOutput();
+        if (idleTimer->isActive())
+            idleTimer->start();
+        scanOutput(stdoutScan, data);
+        appendOutput(data, false);
+    });
+    // the scheduler only tracks the entries that ever ran
+    if (scheduler)
+        scheduler->addItem(this, schedulePriority, scheduleGroups);
+    if (childRegistry)
+        manager->setChildRegistry(childRegistry, childKey);
+    return manager;
+}
+
+void LaunchEntry::setLaunchStats(LaunchStats *stats, const QString &key)
+{
+    launchStats = stats;
+    statsKey = key;
+    emit statsChanged();
+}
+
+QString LaunchEntry::statsSummary() const
+{
+    return launchStats? launchStats->summary(statsKey) : QString{};
+}
+
+void LaunchEntry::setPathResolver(PathResolver *resolver)
+{
+    // the engine calls resolveProgram() when the PATH directories change
+    pathResolver = resolver;
+    resolveProgram();
+}
+
+void LaunchEntry::setPrefetcher(Prefetcher *p, Prefetcher::Mode mode)
+{
+    prefetcher = p;
+    prefetchMode = mode;
+    if (prefetchMode == Prefetcher::Off)
+        return;
+    connect(prefetcher, &Prefetcher::finished, this, [this](const QString& exe) {
+        if (exe == resolvedProgram)
+            prefetchDone.start();
+    });
+    if (prefetchMode == Prefetcher::Startup)
+        requestPrefetch();
+}
+
+LaunchEntry::ReadinessProbe LaunchEntry::ReadinessProbe::compile(const QStringList &readyPatterns,
+                                                                 const QStringList &failPatterns)
+{
+    auto readyList = readyPatterns;
+    auto failList = failPatterns;
+    readyList.removeAll({});
+    failList.removeAll({});
+    ReadinessProbe p;
+    p.patterns = readyList + failList;
+    for (const auto& pattern: qAsConst(p.patterns))
+        p.matcher.addPattern(pattern.toUtf8());
+    p.matcher.compile();
+    p.readyCount = readyList.size();
+    return p;
+}
+
+void LaunchEntry::setReadinessProbe(const ReadinessProbe &p)
+{
+    // the tables are implicitly shared with every other user of the probe
+    probe = p;
+}
+
+void LaunchEntry::hovered()
+{
+    if (prefetchMode == Prefetcher::Hover && state() == QProcess::NotRunning)
+        requestPrefetch();
+}
+
+void LaunchEntry::startStop()
+{
+    switch (state()) {
+    case QProcess::NotRunning:
+        if (isQueued() && scheduler) {
+            scheduler->cancel(this);
+            break;
+        }
+        launchTimer.start();
+        start();
+        break;
+    case QProcess::Starting:
+    case QProcess::Running:
+        // a click on a paused application resumes it
+        if (isFrozen())
+            setFrozen(false);
+        else
+            stop();
+        break;
+    }
+}
+
+void LaunchEntry::setScheduler(LaunchScheduler *s, int priority, const QStringList &groups)
+{
+    scheduler = s;
+    schedulePriority = priority;
+    scheduleGroups = groups;
+}
+
+void LaunchEntry::setChildRegistry(ChildRegistry *registry, const QString &key)
+{
+    childRegistry = registry;
+    childKey = key;
+    // attaches to an instance left running by a previous launcher
+    if (registry->contains(key))
+        process();
+}
+
+void LaunchEntry::setQueuePosition(int position)
+{
+    if (queuePosition == position)
+        return;
+    // time spent waiting for a slot is not launch latency
+    if (position > 0)
+        launchTimer.invalidate();
+    queuePosition = position;
+    emit queuePositionChanged(position);
+}
+
+void LaunchEntry::start()
+{
+    process();
+    if (scheduler)
+        scheduler->request(this);
+    else
+        spawn();
+}
+
+void LaunchEntry::spawn()
+{
+    if (resolvedProgram.isEmpty())
+        resolveProgram();
+    if (resolvedProgram.isEmpty()) {
+        qDebug() << "cannot start" << program << ": not found";
+        return;
+    }
+    if (!launchTimer.isValid())
+        launchTimer.start();
+    awaitingOutput = true;
+    stdoutScan = stderrScan = 0;
+    failed = false;
+    launchPrefetched = prefetchDone.isValid() && !prefetchDone.hasExpired(PREFETCH_WARM_MS);
+    process()->start(resolvedProgram, arguments);
+}
+
+void LaunchEntry::stop()
+{
+    if (!manager)
+        return;
+    // a stopped process would not act on SIGTERM before being resumed
+    manager->setFrozen(false);
+    manager->terminate();
+}
+
+void LaunchEntry::restart()
+{
+    if (state() == QProcess::NotRunning) {
+        start();
+        return;
+    }
+    restartPending = true;
+    stop();
+}
+
+void LaunchEntry::appendOutput(const QByteArray &data, bool isError)
+{
+    outputTail.append(data);
+    if (outputTail.size() > OUTPUT_TAIL_BYTES)
+        outputTail.remove(0, outputTail.size() - OUTPUT_TAIL_BYTES);
+    emit outputReceived(data, isError);
+}
+
+void LaunchEntry::setFreezePolicy(bool whileHidden, int idleMinutes)
+{
+    freezeWhileHidden = whileHidden;
+    idleInterval = qMax(idleMinutes, 0) * 60 * 1000;
+    if (idleTimer)
+        idleTimer->setInterval(idleInterval);
+}
+
+void LaunchEntry::freeze(FreezeReason reason)
+{
+    if (state() != QProcess::Running)
+        return;
+    freezeReasons |= reason;
+    idleTimer->stop();
+    manager->setFrozen(true);
+}
+
+void LaunchEntry::thaw(FreezeReason reason)
+{
+    freezeReasons &= ~reason;
+    if (freezeReasons || !isFrozen())
+        return;
+    manager->setFrozen(false);
+    if (idleInterval > 0)
+        idleTimer->start();
+}
+
+void LaunchEntry::setFrozen(bool frozen)
+{
+    if (frozen) {
+        freeze(FreezeByUser);
+    } else {
+        // resuming by hand overrides every automatic reason
+        freezeReasons = FreezeByUser;
+        thaw(FreezeByUser);
+    }
+}
+
+LaunchEntry::PressureAction LaunchEntry::pressureActionFromName(const QString &name)
+{
+    if (name == "freeze")
+        return PressureFreeze;
+    if (name == "renice")
+        return PressureRenice;
+    if (name == "stop")
+        return PressureStop;
+    if (!name.isEmpty())
+        qDebug() << "unknown pressure action" << name;
+    return PressureIgnore;
+}
+
+void LaunchEntry::setUnderPressure(bool underPressure)
+{
+    switch (pressureAction) {
+    case PressureIgnore:
+        break;
+    case PressureFreeze:
+        if (underPressure)
+            freeze(FreezeUnderPressure);
+        else
+            thaw(FreezeUnderPressure);
+        break;
+    case PressureRenice:
+        if (manager)
+            manager->setLowPriority(underPressure);
+        break;
+    case PressureStop:
+        if (underPressure && state() != QProcess::NotRunning) {
+            stoppedByPressure = true;
+            stop();
+        } else if (!underPressure && stoppedByPressure) {
+            stoppedByPressure = false;
+            if (state() == QProcess::NotRunning)
+                start();
+        }
+        break;
+    }
+}
+
+void LaunchEntry::setLauncherVisible(bool visible)
+{
+    if (!freezeWhileHidden)
+        return;
+    if (visible)
+        thaw(FreezeWhileHidden);
+    else
+        freeze(FreezeWhileHidden);
+}
+
+void LaunchEntry::recordPhase(LaunchStats::Phase phase, qint64 nsecsAgo)
+{
+    if (!launchStats || !launchTimer.isValid())
+        return;
+    launchStats->record(statsKey, phase, (launchTimer.nsecsElapsed() - nsecsAgo) / 1000,
+                        launchPrefetched);
+    emit statsChanged();
+}
+
+void LaunchEntry::setReady(bool isReady)
+{
+    if (ready == isReady)
+        return;
+    ready = isReady;
+    emit readyChanged(ready);
+}
+
+void LaunchEntry::scanOutput(int &scanState, const QByteArray &data)
+{
+    if (probe.matcher.isEmpty())
+        return;
+    const auto matches = probe.matcher.scan(scanState, data);
+    for (auto id: matches) {
+        if (id < probe.readyCount) {
+            if (!failed)
+                setReady(true);
+        } else if (!failed) {
+            qDebug() << "readiness probe failed:" << probe.patterns.at(id);
+            failed = true;
+            setReady(false);
+            emit probeFailed(probe.patterns.at(id));
+        }
+    }
+}
+
+void LaunchEntry::requestPrefetch()
+{
+    if (!prefetcher || !isAvailable())
+        return;
+    if (prefetchRequested.isValid() && !prefetchRequested.hasExpired(PREFETCH_HOVER_MS))
+        return;
+    prefetchRequested.start();
+    auto libraryPath = environment.value("LD_LIBRARY_PATH").split(QDir::listSeparator(), Qt::SkipEmptyParts);
+    prefetcher->prefetch(resolvedProgram, libraryPath);
+}
+
+void LaunchEntry::resolveProgram()
+{
+    auto wasAvailable = isAvailable();
+    if (program.isEmpty())
+        resolvedProgram.clear();
+    else if (pathResolver)
+        resolvedProgram = pathResolver->resolve(program, workingDirectory);
+    else
+        resolvedProgram = program;
+    if (wasAvailable != isAvailable())
+        emit availableChanged(isAvailable());
+}
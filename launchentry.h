@@ -0,0 +1,170 @@
+#ifndef LAUNCHENTRY_H
+#define LAUNCHENTRY_H
+
+#include <QObject>
+#include <QProcess>
+#include <QElapsedTimer>
+
+#include "launchprocess.h"
+#include "launchstats.h"
+#include "prefetcher.h"
+#include "patternmatcher.h"
+
+class QTimer;
+class PathResolver;
+class LaunchScheduler;
+
+// One application of the configuration and its process, without any
+// widget: shared by the launcher window and the headless daemon. The
+// process, its timers and its scheduler slot are only created once the
+// application is started (or found running), so a configuration of
+// thousands of entries costs little more than their strings, which the
+// instances of a matrix share.
+class LaunchEntry : public QObject
+{
+    Q_OBJECT
+
+public:
+    // Why the application is frozen; it is thawed once no reason is left
+    enum FreezeReason {
+        FreezeByUser = 0x1,
+        FreezeWhileHidden = 0x2,
+        FreezeWhenIdle = 0x4,
+        FreezeUnderPressure = 0x8,
+    };
+
+    // What to do with the application while the system is under pressure
+    enum PressureAction {
+        PressureIgnore,
+        PressureFreeze,
+        PressureRenice,
+        PressureStop,
+    };
+
+    static PressureAction pressureActionFromName(const QString& name);
+
+    // Ready and fail patterns compiled once, and shared by every entry
+    // using the same ones
+    struct ReadinessProbe {
+        PatternMatcher matcher;
+        QStringList patterns;
+        int readyCount = 0;
+
+        static ReadinessProbe compile(const QStringList& readyPatterns, const QStringList& failPatterns);
+    };
+
+    explicit LaunchEntry(const QString& text,
+                         const QString& iconName,
+                         const QString& path,
+                         const QString& workdir,
+                         const QProcessEnvironment &env,
+                         LaunchProcess::Backend backend,
+                         QObject *parent = nullptr);
+
+    void setLaunchStats(LaunchStats *stats, const QString& key);
+    void setPathResolver(PathResolver *resolver);
+    void setPrefetcher(Prefetcher *prefetcher, Prefetcher::Mode mode);
+    void setReadinessProbe(const ReadinessProbe& probe);
+    void setScheduler(LaunchScheduler *scheduler, int priority, const QStringList& groups);
+    void setChildRegistry(ChildRegistry *registry, const QString& key);
+    void setQueuePosition(int position);
+    void setFreezePolicy(bool whileHidden, int idleMinutes);
+    void setPressureAction(PressureAction action) { pressureAction = action; }
+
+    QString text() const { return label; }
+    QString iconName() const { return icon; }
+    QString programName() const { return program; }
+    bool isAvailable() const { return !resolvedProgram.isEmpty(); }
+    bool isReady() const { return ready; }
+    bool isFailed() const { return failed; }
+    bool hasReadinessProbe() const { return probe.readyCount > 0; }
+    bool hasPressureAction() const { return pressureAction != PressureIgnore; }
+    bool isQueued() const { return queuePosition > 0; }
+    int positionInQueue() const { return queuePosition; }
+    bool isFrozen() const { return manager && manager->isFrozen(); }
+    qint64 processId() const { return manager? manager->processId() : 0; }
+    // Last output of the application, stdout and stderr interleaved
+    QByteArray recentOutput() const { return outputTail; }
+    QProcess::ProcessState state() const { return manager? manager->state() : QProcess::NotRunning; }
+    // Launch latency percentiles, empty without statistics
+    QString statsSummary() const;
+
+    void freeze(FreezeReason reason);
+    void thaw(FreezeReason reason);
+
+public slots:
+    void startStop();
+
+    void start();
+    void stop();
+    void restart();
+    void spawn();
+    void setFrozen(bool frozen);
+    void setLauncherVisible(bool visible);
+    void setUnderPressure(bool underPressure);
+    // The pointer is over the entry in a front-end
+    void hovered();
+    // Looks the program up again, after the PATH directories changed
+    void resolveProgram();
+
+signals:
+    void stateChange(bool started);
+    void availableChanged(bool available);
+    void readyChanged(bool ready);
+    void probeFailed(const QString& pattern);
+    void queuePositionChanged(int position);
+    void frozenChanged(bool frozen);
+    void statsChanged();
+    void outputReceived(const QByteArray& data, bool isError);
+    void exited(int exitCode, bool crashed);
+    void restarted();
+
+private:
+    LaunchProcess *process();
+    void recordPhase(LaunchStats::Phase phase, qint64 nsecsAgo = 0);
+    void requestPrefetch();
+    void setReady(bool isReady);
+    void scanOutput(int& scanState, const QByteArray& data);
+    void appendOutput(const QByteArray& data, bool isError);
+
+    LaunchProcess *manager;
+    LaunchProcess::Backend backend;
+    QProcessEnvironment environment;
+    ChildRegistry *childRegistry;
+    QString childKey;
+    QString label;
+    QString icon;
+    QString program;
+    QStringList arguments;
+    QString workingDirectory;
+    QString resolvedProgram;
+    PathResolver *pathResolver;
+    LaunchStats *launchStats;
+    QString statsKey;
+    QElapsedTimer launchTimer;
+    bool awaitingOutput;
+    Prefetcher *prefetcher;
+    Prefetcher::Mode prefetchMode;
+    QElapsedTimer prefetchRequested;
+    QElapsedTimer prefetchDone;
+    bool launchPrefetched;
+    bool ready;
+    bool failed;
+    ReadinessProbe probe;
+    int stdoutScan;
+    int stderrScan;
+    LaunchScheduler *scheduler;
+    int schedulePriority;
+    QStringList scheduleGroups;
+    int queuePosition;
+    int freezeReasons;
+    bool freezeWhileHidden;
+    QTimer *idleTimer;
+    int idleInterval;
+    PressureAction pressureAction;
+    bool stoppedByPressure;
+    bool restartPending;
+    QByteArray outputTail;
+};
+
+#endif // LAUNCHENTRY_H
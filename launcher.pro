@@ -12,6 +12,12 @@ TARGET = applauncher
 TEMPLATE = app
 
 include(qtsingleapplication/src/qtsingleapplication.pri)
+include(embedconfig.pri)
+
+# Built-in configuration used when launcher-conf.json is missing or broken;
+# custom builds can embed a site-wide one with qmake DEFAULT_CONFIG=<file>
+isEmpty(DEFAULT_CONFIG): DEFAULT_CONFIG = default-config.json
+embedConfig($$DEFAULT_CONFIG, default-config.inc)
 
 # The following define makes your compiler emit warnings if you use
 # any feature of Qt which has been marked as deprecated (the exact warnings
@@ -28,16 +34,60 @@ CONFIG += c++17
 
 SOURCES += \
         aboutdialog.cpp \
+        cgroupfreezer.cpp \
+        childregistry.cpp \
+        configloader.cpp \
+        controlclient.cpp \
+        controlconnection.cpp \
+        controlserver.cpp \
+        entrymatrix.cpp \
+        cronschedule.cpp \
         flowlayout.cpp \
+        launchentry.cpp \
+        launcherengine.cpp \
+        launcherhost.cpp \
         launcheritem.cpp \
+        launchgroups.cpp \
+        launchprocess.cpp \
+        launchscheduler.cpp \
+        launchstats.cpp \
         main.cpp \
-        MainWidget.cpp
+        MainWidget.cpp \
+        pathresolver.cpp \
+        patternmatcher.cpp \
+        prefetcher.cpp \
+        pressuremonitor.cpp \
+        remotewidget.cpp \
+        scheduledlaunches.cpp \
+        timerwheel.cpp
 
 HEADERS += \
         MainWidget.h \
         aboutdialog.h \
+        cgroupfreezer.h \
+        childregistry.h \
+        configloader.h \
+        controlclient.h \
+        controlconnection.h \
+        controlserver.h \
+        entrymatrix.h \
+        cronschedule.h \
         flowlayout.h \
-        launcheritem.h
+        launchentry.h \
+        launcherengine.h \
+        launcherhost.h \
+        launcheritem.h \
+        launchgroups.h \
+        launchprocess.h \
+        launchscheduler.h \
+        launchstats.h \
+        pathresolver.h \
+        patternmatcher.h \
+        prefetcher.h \
+        pressuremonitor.h \
+        remotewidget.h \
+        scheduledlaunches.h \
+        timerwheel.h
 
 FORMS += \
         MainWidget.ui \
@@ -49,6 +99,9 @@ FORMS += \
 #DEFINES += QAPPLICATION_CLASS=QApplication
 
 unix {
+    SOURCES += detachedprocess.cpp spawnprocess.cpp
+    HEADERS += detachedprocess.h spawnprocess.h
+
     QMAKE_LFLAGS_RELEASE += -static-libstdc++ -static-libgcc
     QMAKE_LFLAGS_DEBUG += -static-libstdc++ -static-libgcc
     isEmpty(PREFIX) {
@@ -75,5 +128,4 @@ DISTFILES += \
     desktop-integration.sh
 
 RESOURCES += \
-    default.qrc \
     images.qrc
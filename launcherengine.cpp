@@ -0,0 +1,313 @@
+#include "launcherengine.h"
+#include "childregistry.h"
+#include "embeddedconfig.h"
+#include "entrymatrix.h"
+#include "launchentry.h"
+#include "launchgroups.h"
+#include "launcherhost.h"
+#include "launchscheduler.h"
+#include "launchstats.h"
+#include "pathresolver.h"
+#include "prefetcher.h"
+#include "pressuremonitor.h"
+#include "scheduledlaunches.h"
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QPair>
+#include <QStandardPaths>
+#include <QProcessEnvironment>
+
+#include <QtDebug>
+
+#ifdef Q_OS_WIN
+constexpr auto PATH_SEPARATOR = ';';
+#else
+constexpr auto PATH_SEPARATOR = ':';
+#endif
+constexpr auto CONF_NAME = "launcher-conf.json";
+constexpr auto SHARE_DIR = "applauncher";
+constexpr auto RESOURCE_DIR = "resources";
+constexpr auto RESOURCE_PREFIX = "res:";
+
+constexpr char DEFAULT_CONFIG_TEXT[] =
+#include "default-config.inc"
+;
+EMBEDDED_CONFIG(DEFAULT_CONFIG, DEFAULT_CONFIG_TEXT);
+
+static bool isAppImage()
+{
+#ifdef Q_OS_WIN
+    // In windows be linke as appImage
+    return true;
+#else
+    return qEnvironmentVariableIsSet("APPDIR");
+#endif
+}
+
+static QString pathJoin(const QStringList& parts)
+{
+    return parts.join(QDir::separator());
+}
+
+static QString appFile()
+{
+#ifdef Q_OS_LINUX
+    if (isAppImage())
+        return qgetenv("ARGV0");
+    // no application object yet on the fast client path of main()
+    if (!QCoreApplication::instance())
+        return QFileInfo{"/proc/self/exe"}.canonicalFilePath();
+#endif
+    if (!QCoreApplication::instance())
+        return {};
+    return QCoreApplication::applicationFilePath();
+}
+
+static QString appPath()
+{
+    return QFileInfo(appFile()).absolutePath();
+}
+
+static QString sharePath()
+{
+    return pathJoin({ isAppImage()? appPath() : pathJoin({ appPath(), "..", "share" }), SHARE_DIR });
+}
+
+static QString resPath()
+{
+    return pathJoin({ sharePath(), RESOURCE_DIR });
+}
+
+static QStringList toStringList(const QJsonValue& v)
+{
+    if (v.isArray())
+        return QVariant{v.toArray().toVariantList()}.toStringList();
+    if (v.isString() && !v.toString().isEmpty())
+        return { v.toString() };
+    return {};
+}
+
+static void adjustInitialEnv()
+{
+    auto homePath = QDir::home().absolutePath();
+    if (!qEnvironmentVariableIsSet("HOME")) {
+        auto homePaths = QStandardPaths::standardLocations(QStandardPaths::HomeLocation);
+        if (!homePaths.isEmpty())
+            homePath = homePaths.first();
+        qputenv("HOME", homePath.toLocal8Bit());
+    }
+    auto app = appFile().toLocal8Bit();
+    auto appDir = appPath().toLocal8Bit();
+    auto resDir = resPath().toLocal8Bit();
+
+    qputenv("APPLICATION_FILE_PATH", app);
+    qputenv("APPLICATION_DIR_PATH", appDir);
+    qputenv("APPLICATION_RESOURCE_PATH", resDir);
+    if (isAppImage())
+        qputenv("APPLICATION_REAL_FILE_PATH",
+                QCoreApplication::applicationDirPath().toLocal8Bit());
+}
+
+QString LauncherEngine::configurationFile()
+{
+    return pathJoin({ sharePath(), CONF_NAME });
+}
+
+QJsonObject LauncherEngine::defaultConfiguration()
+{
+    return DEFAULT_CONFIG.toJsonObject();
+}
+
+QProcessEnvironment LauncherEngine::launcherEnvironment()
+{
+    adjustInitialEnv();
+    return QProcessEnvironment::systemEnvironment();
+}
+
+QString LauncherEngine::expand(const QString& e) const
+{
+    QString r;
+    int i=0;
+    r.reserve(e.size());
+    while (i<e.size()) {
+        if (e[i] == QChar{'$'} && e[i+1] == QChar{'{'}) {
+            i+=2;
+            int idxEnd = e.indexOf('}', i);
+            QString var = e.mid(i, idxEnd - i);
+            QString val = environment.contains(var)? environment.value(var) : QString{"${%1}"}.arg(var);
+            r.append(val);
+            i = idxEnd + 1;
+        } else {
+            r.append(e[i]);
+            i++;
+        }
+    }
+    return r;
+}
+
+LauncherEngine::LauncherEngine(const QJsonObject &doc,
+                               LauncherHost *host,
+                               const QString &file,
+                               const QString &prefix,
+                               QObject *parent)
+    : QObject{parent},
+      config{doc},
+      configFile{file},
+      namePrefix{prefix},
+      environment{host->baseEnvironment()},
+      launchGroups{new LaunchGroups{this}}
+{
+    // the environment of each configuration is its own: nothing is set
+    // in the launcher process, which may host other configurations
+    auto resArray = doc.value("res").toArray();
+    for (const auto& a: qAsConst(resArray))
+        resourceDirs.append(expand(a.toString()));
+
+    auto sysPath = environment.value("PATH");
+    auto newPath = QStringList{};
+    auto pathArray = doc.value("path").toArray();
+    for (const auto& a: qAsConst(pathArray))
+        newPath.append(expand(a.toString()));
+    newPath.append(sysPath);
+    auto pathStr = newPath.join(PATH_SEPARATOR);
+    if (!newPath.isEmpty()) {
+        qDebug() << pathStr << newPath;
+        environment.insert("PATH", pathStr);
+    }
+    auto pathResolver = new PathResolver{pathStr.split(PATH_SEPARATOR, Qt::SkipEmptyParts), this};
+    auto envObj = doc.value("env").toObject();
+    for (auto it = envObj.constBegin(); it != envObj.constEnd(); ++it)
+        environment.insert(it.key(), expand(it.value().toString()));
+
+    auto spawnBackend = LaunchProcess::backendFromName(doc.value("spawn").toString());
+    auto launchStats = host->launchStats();
+    auto prefetcher = host->prefetcher();
+    QHash<QString, int> groupLimits;
+    auto groupLimitsObj = doc.value("groupLimits").toObject();
+    for (auto it = groupLimitsObj.constBegin(); it != groupLimitsObj.constEnd(); ++it)
+        groupLimits.insert(it.key(), it.value().toInt());
+    auto scheduler = host->scheduler();
+    scheduler->addLimits(doc.value("maxConcurrent").toInt(), groupLimits);
+    auto scheduledLaunches = new ScheduledLaunches{this};
+    auto childRegistry = host->childRegistry();
+    PressureMonitor *pressureMonitor = nullptr;
+    if (doc.contains("pressure")) {
+        auto pressureObj = doc.value("pressure").toObject();
+        pressureMonitor = new PressureMonitor{pressureObj.value("path").toString("/proc/pressure"), this};
+        pressureMonitor->setPolling(pressureObj.value("poll").toBool());
+        if (!pressureObj.contains("memory") && !pressureObj.contains("cpu"))
+            pressureObj.insert("memory", "some 150000 2000000");
+        for (const auto& resource: QStringList{"memory", "cpu"})
+            if (pressureObj.contains(resource))
+                pressureMonitor->watch(resource, pressureObj.value(resource).toString().toLatin1());
+    }
+
+    auto appArray = doc.value("applications").toArray();
+    // shared by entries with the same environment (matrix instances)
+    QJsonObject lastEnvObj;
+    auto lastProcEnv = environment;
+    // and so are their icons and compiled readiness probes
+    QHash<QString, QString> icons;
+    QHash<QPair<QStringList, QStringList>, LaunchEntry::ReadinessProbe> probes;
+    auto addApplication = [&](const QJsonObject& o) {
+        auto text = expand(o.value("text").toString());
+        auto exec = expand(o.value("exec").toString());
+        auto work = expand(o.value("work").toString());
+        auto procEnvObj = o.value("env").toObject();
+        if (procEnvObj != lastEnvObj) {
+            lastEnvObj = procEnvObj;
+            lastProcEnv = environment;
+            for (auto it = procEnvObj .constBegin(); it != procEnvObj .constEnd(); ++it){
+                auto k = it.key();
+                auto v = expand(it.value().toString());
+                qDebug() << "custom env" << k << v;
+                lastProcEnv.insert(k, v);
+            }
+        }
+        auto procEnv = lastProcEnv;
+        auto backend = LaunchProcess::backendFromName(o.value("spawn").toString(), spawnBackend);
+        if (o.value("persistent").toBool())
+            backend = LaunchProcess::DetachedBackend;
+        auto name = o.value("name").toString(text);
+        // the display prefix changes with the order configurations are
+        // opened in, the file does not
+        auto key = configFile + '#' + name;
+        auto iconName = o.value("icon").toString();
+        auto icon = icons.find(iconName);
+        if (icon == icons.end())
+            icon = icons.insert(iconName, resource(expand(iconName)));
+        auto entry = new LaunchEntry{text, *icon, exec, work, procEnv, backend, this};
+        entry->setLaunchStats(launchStats, key);
+        entry->setPathResolver(pathResolver);
+        entry->setPrefetcher(prefetcher, Prefetcher::modeFromName(o.value("prefetch").toString()));
+        auto patterns = qMakePair(toStringList(o.value("readyPatterns")), toStringList(o.value("failPatterns")));
+        auto probe = probes.find(patterns);
+        if (probe == probes.end())
+            probe = probes.insert(patterns, LaunchEntry::ReadinessProbe::compile(patterns.first, patterns.second));
+        entry->setReadinessProbe(*probe);
+        auto groups = toStringList(o.value("group"));
+        launchGroups->addItem(name, entry,
+                              toStringList(o.value("depends")), groups);
+        entry->setScheduler(scheduler, o.value("priority").toInt(), groups);
+        if (o.contains("schedule"))
+            scheduledLaunches->addJob(entry, o.value("schedule").toObject());
+        auto freezeObj = o.value("freeze").toObject();
+        entry->setFreezePolicy(freezeObj.value("whileHidden").toBool(), freezeObj.value("idleMinutes").toInt());
+        entry->setPressureAction(LaunchEntry::pressureActionFromName(o.value("onPressure").toString()));
+        if (pressureMonitor && entry->hasPressureAction())
+            connect(pressureMonitor, &PressureMonitor::pressureChanged, entry, &LaunchEntry::setUnderPressure);
+        entry->setChildRegistry(childRegistry, key);
+        entryList.append(entry);
+    };
+    for(const auto& a: qAsConst(appArray)) {
+        auto o = a.toObject();
+        if (!o.contains("matrix")) {
+            addApplication(o);
+            continue;
+        }
+        // instances are expanded one at a time from the shared template
+        EntryMatrix matrix{o};
+        // each instance needs a name of its own, for its dependencies,
+        // launch statistics and running process: without a parameter in
+        // it the name is numbered
+        auto baseName = o.value("name").toString(expand(o.value("text").toString()));
+        bool numbered = !matrix.varies(o.contains("name")? o.value("name").toString() : o.value("text").toString());
+        for (int i = 0; i < matrix.size(); i++) {
+            auto instance = matrix.instance(i);
+            if (numbered)
+                instance.insert("name", QString{"%1-%2"}.arg(baseName).arg(i));
+            addApplication(instance);
+        }
+    }
+    connect(pathResolver, &PathResolver::changed, this, [this]() {
+        for (auto entry: qAsConst(entryList))
+            entry->resolveProgram();
+    });
+    const auto cycles = launchGroups->resolve();
+    for (const auto& cycle: cycles)
+        errors.append(QString{"%1: dependency cycle between %2, their dependencies on each other are ignored"}
+                      .arg(configFile, cycle.join(", ")));
+}
+
+QString LauncherEngine::resource(const QString &path) const
+{
+    if (!path.startsWith(RESOURCE_PREFIX))
+        return path;
+    auto name = path.mid(int(qstrlen(RESOURCE_PREFIX)));
+    for (const auto& dir: resourceDirs) {
+        QFileInfo f{QDir{dir}.filePath(name)};
+        if (f.exists())
+            return f.filePath();
+    }
+    qDebug() << "resource" << name << "not found in" << resourceDirs;
+    return path;
+}
+
+void LauncherEngine::setFrontEndVisible(bool visible)
+{
+    for (auto entry: qAsConst(entryList))
+        entry->setLauncherVisible(visible);
+}
@@ -0,0 +1,70 @@
+#ifndef LAUNCHERENGINE_H
+#define LAUNCHERENGINE_H
+
+#include <QObject>
+#include <QJsonObject>
+#include <QList>
+#include <QProcessEnvironment>
+
+class LaunchEntry;
+class LaunchGroups;
+class LauncherHost;
+
+// Everything a configuration describes except the widgets: environment,
+// entries and their processes, groups and schedules. Runs under a
+// QCoreApplication; the launcher window is an optional front-end built on
+// top of it. Several engines can share a LauncherHost.
+class LauncherEngine : public QObject
+{
+    Q_OBJECT
+
+public:
+    // file is the absolute path the configuration was loaded from, which
+    // identifies its entries in the state shared between sessions
+    explicit LauncherEngine(const QJsonObject& config,
+                            LauncherHost *host,
+                            const QString& file = {},
+                            const QString& prefix = {},
+                            QObject *parent = nullptr);
+
+    // Usable before the application object is created
+    static QString configurationFile();
+    // The built-in configuration, for when the configuration file is
+    // missing or broken
+    static QJsonObject defaultConfiguration();
+    // Sets the APPLICATION_* variables and returns the process environment
+    static QProcessEnvironment launcherEnvironment();
+
+    // Replaces the ${VARIABLE} references by their value in the
+    // environment of this configuration
+    QString expand(const QString& s) const;
+    // Looks "res:<name>" up in the "res" directories of this
+    // configuration; other paths are returned unchanged
+    QString resource(const QString& path) const;
+
+    QJsonObject configuration() const { return config; }
+    // Problems met while loading the configuration: files left out and
+    // dependency cycles
+    QStringList loadErrors() const { return errors; }
+    void setLoadErrors(const QStringList& e) { errors = e; }
+    QString file() const { return configFile; }
+    QString prefix() const { return namePrefix; }
+    QList<LaunchEntry *> entries() const { return entryList; }
+    LaunchGroups *groups() const { return launchGroups; }
+
+public slots:
+    // Whether a front-end shows the entries, for the "whileHidden" policy
+    void setFrontEndVisible(bool visible);
+
+private:
+    QJsonObject config;
+    QString configFile;
+    QString namePrefix;
+    QStringList resourceDirs;
+    QStringList errors;
+    QProcessEnvironment environment;
+    QList<LaunchEntry *> entryList;
+    LaunchGroups *launchGroups;
+};
+
+#endif // LAUNCHERENGINE_H
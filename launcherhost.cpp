@@ -0,0 +1,109 @@
+#include "launcherhost.h"
+#include "childregistry.h"
+#include "configloader.h"
+#include "controlserver.h"
+#include "launcherengine.h"
+#include "launchscheduler.h"
+#include "launchstats.h"
+#include "prefetcher.h"
+
+#include <QFileInfo>
+#include <qtlocalpeer.h>
+
+#include <QtDebug>
+
+#include <algorithm>
+
+constexpr auto OPEN_PREFIX = "open ";
+
+LauncherHost::LauncherHost(QObject *parent)
+    : QObject{parent},
+      systemEnvironment{LauncherEngine::launcherEnvironment()},
+      stats{new LaunchStats{LaunchStats::defaultStateFile(), this}},
+      launchScheduler{new LaunchScheduler{0, {}, this}},
+      sharedPrefetcher{new Prefetcher{this}},
+      registry{new ChildRegistry{ChildRegistry::defaultStateFile(), this}},
+      loader{new ConfigLoader{this}},
+      controlServer{new ControlServer{this}}
+{
+}
+
+QString LauncherHost::openMessage(const QString &file)
+{
+    return OPEN_PREFIX + QFileInfo{file}.absoluteFilePath();
+}
+
+void LauncherHost::preload(const QStringList &files)
+{
+    QStringList keys;
+    for (const auto& f: files)
+        keys.append(QFileInfo{f}.absoluteFilePath());
+    collectPreloaded();
+    auto configLoader = loader;
+    pendingConfigs = std::async(std::launch::async, [configLoader, keys]() {
+        QHash<QString, QJsonObject> configs;
+        for (const auto& key: keys)
+            configs.insert(key, configLoader->load(key));
+        return configs;
+    });
+}
+
+void LauncherHost::collectPreloaded()
+{
+    if (!pendingConfigs.valid())
+        return;
+    auto configs = pendingConfigs.get();
+    for (auto it = configs.constBegin(); it != configs.constEnd(); ++it)
+        preloaded.insert(it.key(), it.value());
+}
+
+LauncherEngine *LauncherHost::open(const QString &file)
+{
+    auto key = QFileInfo{file}.absoluteFilePath();
+    if (auto engine = byFile.value(key))
+        return engine;
+
+    QString prefix;
+    collectPreloaded();
+    auto config = preloaded.contains(key)? preloaded.take(key) : loader->load(key);
+    auto errors = loader->errors(key);
+    if (engineList.isEmpty()) {
+        // the first configuration falls back to the default one
+        if (config.isEmpty()) {
+            config = LauncherEngine::defaultConfiguration();
+            if (!errors.isEmpty())
+                errors.append(QString{"%1: using the built-in configuration"}.arg(key));
+        }
+    } else {
+        if (config.isEmpty()) {
+            qWarning() << "cannot open configuration" << key;
+            return nullptr;
+        }
+        // entries of additional configurations are named "<prefix>/<name>"
+        auto base = QFileInfo{key}.completeBaseName();
+        prefix = base;
+        for (int n = 2; std::any_of(engineList.cbegin(), engineList.cend(),
+                                    [&prefix](LauncherEngine *e) { return e->prefix() == prefix; }); n++)
+            prefix = QString{"%1-%2"}.arg(base).arg(n);
+    }
+    qDebug() << "opening" << key << (prefix.isEmpty()? QString{} : "as " + prefix);
+    auto engine = new LauncherEngine{config, this, key, prefix, this};
+    // the engine reports what it found wrong in the loaded configuration
+    engine->setLoadErrors(errors + engine->loadErrors());
+    engineList.append(engine);
+    byFile.insert(key, engine);
+    controlServer->addEngine(engine);
+    emit opened(engine);
+    return engine;
+}
+
+void LauncherHost::serve(QtLocalPeer *peer)
+{
+    connect(peer, &QtLocalPeer::controlConnection, controlServer, &ControlServer::addConnection);
+    connect(peer, &QtLocalPeer::messageReceived, this, [this](const QString& msg) {
+        if (!msg.startsWith(OPEN_PREFIX))
+            return;
+        if (auto engine = open(msg.mid(int(qstrlen(OPEN_PREFIX)))))
+            emit openRequested(engine);
+    });
+}
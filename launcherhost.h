@@ -0,0 +1,73 @@
+#ifndef LAUNCHERHOST_H
+#define LAUNCHERHOST_H
+
+#include <QObject>
+#include <QHash>
+#include <QJsonObject>
+#include <QProcessEnvironment>
+
+#include <future>
+
+class QtLocalPeer;
+class ChildRegistry;
+class ConfigLoader;
+class ControlServer;
+class LaunchScheduler;
+class LaunchStats;
+class LauncherEngine;
+class Prefetcher;
+
+// Hosts any number of configurations in one process. The launch
+// statistics and scheduler, prefetcher, child registry and control server
+// are shared by their engines; further invocations of the launcher hand their
+// configuration over through the single instance socket.
+class LauncherHost : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit LauncherHost(QObject *parent = nullptr);
+
+    // Message asking the running instance to open file
+    static QString openMessage(const QString& file);
+
+    // Starts loading files on a thread of its own, for open() to pick them
+    // up; the caller meanwhile builds whatever does not need them
+    void preload(const QStringList& files);
+    // Opens file, once: the engine already running it otherwise
+    LauncherEngine *open(const QString& file);
+    QList<LauncherEngine *> engines() const { return engineList; }
+
+    // Serves the control protocol and the open requests of peer
+    void serve(QtLocalPeer *peer);
+
+    // The launcher environment before any configuration changed it
+    QProcessEnvironment baseEnvironment() const { return systemEnvironment; }
+    LaunchStats *launchStats() const { return stats; }
+    LaunchScheduler *scheduler() const { return launchScheduler; }
+    Prefetcher *prefetcher() const { return sharedPrefetcher; }
+    ChildRegistry *childRegistry() const { return registry; }
+
+signals:
+    void opened(LauncherEngine *engine);
+    // Another invocation of the launcher asked for engine
+    void openRequested(LauncherEngine *engine);
+
+private:
+    void collectPreloaded();
+
+    QProcessEnvironment systemEnvironment;
+    LaunchStats *stats;
+    LaunchScheduler *launchScheduler;
+    Prefetcher *sharedPrefetcher;
+    ChildRegistry *registry;
+    ConfigLoader *loader;
+    ControlServer *controlServer;
+    QList<LauncherEngine *> engineList;
+    QHash<QString, LauncherEngine *> byFile;
+    // the loader is only used by one thread at a time: open() waits here
+    std::future<QHash<QString, QJsonObject>> pendingConfigs;
+    QHash<QString, QJsonObject> preloaded;
+};
+
+#endif // LAUNCHERHOST_H
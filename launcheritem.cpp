@@ -1,61 +1,53 @@
 #include "launcheritem.h"
 #include "ui_launcheritem.h"
+#include "launchentry.h"
 
-#include <QProcess>
-#include <QDir>
-#include <QTextBrowser>
-#include <QScrollBar>
+#include <QStyle>
+#include <QAction>
 
 #include <QtDebug>
 
-static void insertText(QTextBrowser *b, const QString& t, const QColor& color)
-{
-    auto c = b->textCursor();
-    c.movePosition(QTextCursor::End);
-    c.beginEditBlock();
-    QTextCharFormat fmt;
-    fmt.setForeground(color);
-    c.setCharFormat(fmt);
-    c.insertText(t);
-    c.endEditBlock();
-    b->setTextCursor(c);
-    b->ensureCursorVisible();
-}
-
-LauncherItem::LauncherItem(const QIcon &icon,
-                           const QString &text,
-                           const QString &path,
-                           const QString &workdir,
-                           const QProcessEnvironment &env,
-                           QTextBrowser *log,
+LauncherItem::LauncherItem(LaunchEntry *entry,
+                           const QIcon &icon,
                            QWidget *parent)
     : QWidget{parent},
       ui{new Ui::LauncherItem},
-      manager{new QProcess(this)},
-      execPath{path}
+      launchEntry{entry},
+      pauseAction{new QAction{tr("Pause"), this}}
 {
     ui->setupUi(this);
     ui->iconButton->setIcon(icon.isNull()? QIcon(":/resources/applauncher.png") : icon);
-    ui->iconButton->setText(text);
+    ui->iconButton->setText(entry->text());
     ui->iconButton->setToolButtonStyle(Qt::ToolButtonTextUnderIcon);
     // ui->textLabel->setText(text);
+    ui->textLabel->hide();
 
-    if (!workdir.isEmpty())
-        manager->setWorkingDirectory(workdir);
-    qDebug() << "Process" << text << "env:\n\t" << env.toStringList();
-    manager->setProcessEnvironment(env);
-    connect(ui->iconButton, &QToolButton::clicked, this, &LauncherItem::startStop);
-    connect(manager, &QProcess::stateChanged, this, [this](QProcess::ProcessState state) {
-        bool isStarted = state == QProcess::Running;
-        ui->iconButton->setChecked(isStarted);
-        emit stateChange(isStarted);
+    connect(ui->iconButton, &QToolButton::clicked, entry, &LaunchEntry::startStop);
+    pauseAction->setCheckable(true);
+    pauseAction->setEnabled(false);
+    pauseAction->setChecked(entry->isFrozen());
+    ui->iconButton->addAction(pauseAction);
+    ui->iconButton->setContextMenuPolicy(Qt::ActionsContextMenu);
+    connect(pauseAction, &QAction::triggered, this, [this](bool frozen) {
+        launchEntry->setFrozen(frozen);
+        pauseAction->setChecked(launchEntry->isFrozen());
     });
-    connect(manager, &QProcess::readyReadStandardError, this, [this, log] () {
-        insertText(log, manager->readAllStandardError(), Qt::darkRed);
+    connect(entry, &LaunchEntry::frozenChanged, this, [this](bool frozen) {
+        pauseAction->setChecked(frozen);
+        updateStyle();
     });
-    connect(manager, &QProcess::readyReadStandardOutput, this, [this, log] () {
-        insertText(log, manager->readAllStandardOutput(), Qt::darkBlue);
+    connect(entry, &LaunchEntry::stateChange, this, &LauncherItem::updateState);
+    connect(entry, &LaunchEntry::availableChanged, this, [this]() {
+        updateState();
+        updateToolTip();
     });
+    connect(entry, &LaunchEntry::readyChanged, this, &LauncherItem::updateStyle);
+    connect(entry, &LaunchEntry::probeFailed, this, &LauncherItem::updateStyle);
+    connect(entry, &LaunchEntry::statsChanged, this, &LauncherItem::updateToolTip);
+    connect(entry, &LaunchEntry::queuePositionChanged, this, &LauncherItem::updateQueuePosition);
+    updateState();
+    updateToolTip();
+    updateQueuePosition(entry->positionInQueue());
 }
 
 LauncherItem::~LauncherItem()
@@ -63,30 +55,43 @@ LauncherItem::~LauncherItem()
     delete ui;
 }
 
-void LauncherItem::startStop()
+void LauncherItem::enterEvent(QEvent *event)
 {
-    switch (manager->state()) {
-    case QProcess::NotRunning:
-        start();
-        break;
-    case QProcess::Starting:
-    case QProcess::Running:
-        stop();
-        break;
-    }
+    QWidget::enterEvent(event);
+    launchEntry->hovered();
 }
 
-void LauncherItem::start()
+void LauncherItem::updateState()
 {
-    auto args = QProcess::splitCommand(execPath);
-    if (args.isEmpty())
+    bool isStarted = launchEntry->state() == QProcess::Running;
+    pauseAction->setEnabled(isStarted);
+    ui->iconButton->setChecked(isStarted);
+    // a running instance keeps its tile usable so it can still be stopped
+    setEnabled(launchEntry->isAvailable() || launchEntry->state() != QProcess::NotRunning);
+    updateStyle();
+}
+
+void LauncherItem::updateQueuePosition(int position)
+{
+    ui->textLabel->setText(position > 0? tr("Queued #%1").arg(position) : QString{});
+    ui->textLabel->setVisible(position > 0);
+}
+
+void LauncherItem::updateToolTip()
+{
+    if (!launchEntry->isAvailable() && !launchEntry->programName().isEmpty()) {
+        ui->iconButton->setToolTip(tr("%1: command not found").arg(launchEntry->programName()));
         return;
-    auto cmd = args.first();
-    auto argv = args.mid(1);
-    manager->start(cmd, argv);
+    }
+    ui->iconButton->setToolTip(launchEntry->statsSummary());
 }
 
-void LauncherItem::stop()
+void LauncherItem::updateStyle()
 {
-    manager->terminate();
+    auto b = ui->iconButton;
+    b->setProperty("ready", launchEntry->isReady() && launchEntry->hasReadinessProbe());
+    b->setProperty("failed", launchEntry->isFailed());
+    b->setProperty("frozen", launchEntry->isFrozen());
+    b->style()->unpolish(b);
+    b->style()->polish(b);
 }
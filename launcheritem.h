@@ -2,42 +2,39 @@
 #define LAUNCHERITEM_H
 
 #include <QWidget>
-#include <QProcess>
 
 namespace Ui {
 class LauncherItem;
 }
 
-class QProcess;
-class QTextBrowser;
+class LaunchEntry;
 
+// Tile of the launcher window showing one LaunchEntry. Holds no state of
+// its own: it can be destroyed and created again at any time.
 class LauncherItem : public QWidget
 {
     Q_OBJECT
 
 public:
-    explicit LauncherItem(const QIcon &icon,
-                          const QString& text,
-                          const QString& path,
-                          const QString& workdir,
-                          const QProcessEnvironment &env,
-                          QTextBrowser *log,
+    explicit LauncherItem(LaunchEntry *entry,
+                          const QIcon &icon,
                           QWidget *parent = nullptr);
     ~LauncherItem();
 
-public slots:
-    void startStop();
+    LaunchEntry *entry() const { return launchEntry; }
 
-    void start();
-    void stop();
-
-signals:
-    void stateChange(bool started);
+protected:
+    void enterEvent(QEvent *event) override;
 
 private:
+    void updateToolTip();
+    void updateState();
+    void updateStyle();
+    void updateQueuePosition(int position);
+
     Ui::LauncherItem *ui;
-    QProcess *manager;
-    QString execPath;
+    LaunchEntry *launchEntry;
+    QAction *pauseAction;
 };
 
 #endif // LAUNCHERITEM_H
@@ -0,0 +1,261 @@
+#include "launchgroups.h"
+#include "launchentry.h"
+
+#include <QPair>
+#include <QVector>
+
+#include <QtDebug>
+
+static QStringList topologicalOrder(const QStringList& names,
+                                    const QHash<QString, QStringList>& depends)
+{
+    QHash<QString, int> indegree;
+    QHash<QString, QStringList> dependents;
+    for (const auto& n: names) {
+        const auto deps = depends.value(n);
+        indegree.insert(n, deps.size());
+        for (const auto& d: deps)
+            dependents[d].append(n);
+    }
+    QStringList ready;
+    for (const auto& n: names)
+        if (indegree.value(n) == 0)
+            ready.append(n);
+    QStringList order;
+    while (!ready.isEmpty()) {
+        auto n = ready.takeFirst();
+        order.append(n);
+        for (const auto& d: dependents.value(n))
+            if (--indegree[d] == 0)
+                ready.append(d);
+    }
+    return order;
+}
+
+// Strongly connected components of the dependency graph (Tarjan), without
+// recursion so long dependency chains cannot overflow the stack. Entries
+// outside any cycle come out as components of their own.
+static QList<QStringList> stronglyConnected(const QStringList& names,
+                                            const QHash<QString, QStringList>& depends)
+{
+    QHash<QString, int> index;
+    QHash<QString, int> lowLink;
+    QSet<QString> onStack;
+    QStringList stack;
+    QList<QStringList> components;
+    // node being visited and the next of its dependencies to look at
+    QVector<QPair<QString, int>> path;
+
+    for (const auto& root: names) {
+        if (index.contains(root))
+            continue;
+        path.append({root, 0});
+        while (!path.isEmpty()) {
+            auto& top = path.last();
+            const auto n = top.first;
+            if (top.second == 0 && !index.contains(n)) {
+                index.insert(n, index.size());
+                lowLink.insert(n, index.value(n));
+                stack.append(n);
+                onStack.insert(n);
+            }
+            const auto& deps = depends[n];
+            if (top.second < deps.size()) {
+                const auto d = deps.at(top.second++);
+                if (!index.contains(d))
+                    path.append({d, 0});
+                else if (onStack.contains(d))
+                    lowLink[n] = qMin(lowLink.value(n), index.value(d));
+                continue;
+            }
+            path.removeLast();
+            if (!path.isEmpty()) {
+                const auto& parent = path.last().first;
+                lowLink[parent] = qMin(lowLink.value(parent), lowLink.value(n));
+            }
+            if (lowLink.value(n) != index.value(n))
+                continue;
+            QStringList component;
+            QString m;
+            do {
+                m = stack.takeLast();
+                onStack.remove(m);
+                component.prepend(m);
+            } while (m != n);
+            components.append(component);
+        }
+    }
+    return components;
+}
+
+LaunchGroups::LaunchGroups(QObject *parent)
+    : QObject{parent},
+      pumping{false},
+      repump{false}
+{
+}
+
+bool LaunchGroups::addItem(const QString &name,
+                           LaunchEntry *item,
+                           const QStringList &depends,
+                           const QStringList &groups)
+{
+    if (nodes.contains(name)) {
+        qDebug() << "duplicated application name" << name << ", ignoring its dependencies";
+        return false;
+    }
+    nodes.insert(name, Node{item, depends, groups});
+    insertion.append(name);
+    return true;
+}
+
+void LaunchGroups::watchPrerequisites()
+{
+    // only a prerequisite changing can unblock a pending entry, the
+    // others are started as soon as they are scheduled
+    QSet<QString> watched;
+    for (const auto& node: qAsConst(nodes)) {
+        for (const auto& d: node.depends) {
+            if (watched.contains(d))
+                continue;
+            watched.insert(d);
+            auto item = nodes.value(d).item;
+            connect(item, &LaunchEntry::readyChanged, this, &LaunchGroups::pump);
+            connect(item, &LaunchEntry::stateChange, this, &LaunchGroups::pump);
+            connect(item, &LaunchEntry::probeFailed, this, &LaunchGroups::pump);
+            connect(item, &LaunchEntry::queuePositionChanged, this, &LaunchGroups::pump);
+        }
+    }
+}
+
+QList<QStringList> LaunchGroups::resolve()
+{
+    QHash<QString, QStringList> depends;
+    QList<QStringList> cycles;
+    for (auto it = nodes.begin(); it != nodes.end(); ++it) {
+        QStringList known;
+        for (const auto& d: qAsConst(it->depends)) {
+            if (d == it.key()) {
+                qWarning() << it.key() << "depends on itself";
+                cycles.append({d});
+            } else if (!nodes.contains(d)) {
+                qDebug() << it.key() << "depends on unknown application" << d;
+            } else {
+                known.append(d);
+            }
+        }
+        it->depends = known;
+        depends.insert(it.key(), known);
+    }
+
+    order = topologicalOrder(insertion, depends);
+    if (order.size() == insertion.size()) {
+        watchPrerequisites();
+        return cycles;
+    }
+
+    // Only the edges inside a cycle are cut: entries that merely depend on
+    // a cycle keep their dependencies and wait for it as usual
+    const auto components = stronglyConnected(insertion, depends);
+    for (const auto& component: components) {
+        if (component.size() < 2)
+            continue;
+        for (const auto& n: component) {
+            auto& deps = nodes[n].depends;
+            for (const auto& c: component)
+                deps.removeAll(c);
+            depends.insert(n, deps);
+        }
+        qWarning() << "dependency cycle between" << component;
+        cycles.append(component);
+    }
+    order = topologicalOrder(insertion, depends);
+    watchPrerequisites();
+    return cycles;
+}
+
+QStringList LaunchGroups::groups() const
+{
+    QStringList r;
+    for (const auto& n: order)
+        for (const auto& g: nodes.value(n).groups)
+            if (!r.contains(g))
+                r.append(g);
+    return r;
+}
+
+LaunchEntry *LaunchGroups::item(const QString &name) const
+{
+    return nodes.value(name).item;
+}
+
+void LaunchGroups::startGroup(const QString &group)
+{
+    for (const auto& n: qAsConst(order))
+        if (nodes.value(n).groups.contains(group))
+            schedule(n);
+    pump();
+}
+
+void LaunchGroups::startWithDependencies(const QString &name)
+{
+    if (!nodes.contains(name))
+        return;
+    schedule(name);
+    pump();
+}
+
+void LaunchGroups::schedule(const QString &name)
+{
+    if (pending.contains(name))
+        return;
+    pending.insert(name);
+    for (const auto& d: nodes.value(name).depends)
+        schedule(d);
+}
+
+void LaunchGroups::pump()
+{
+    // every state change of every entry comes here: nothing to do unless
+    // a group start is waiting
+    if (pending.isEmpty())
+        return;
+    // starting an item may synchronously report its new state back here
+    if (pumping) {
+        repump = true;
+        return;
+    }
+    pumping = true;
+    do {
+        repump = false;
+        for (const auto& name: qAsConst(order)) {
+            if (!pending.contains(name))
+                continue;
+            const auto node = nodes.value(name);
+            bool blocked = false;
+            bool failed = false;
+            for (const auto& d: node.depends) {
+                auto dep = nodes.value(d).item;
+                if (dep->isReady())
+                    continue;
+                if (dep->isFailed())
+                    failed = true;
+                else if (pending.contains(d) || dep->isQueued() || dep->state() != QProcess::NotRunning)
+                    blocked = true;
+                else
+                    failed = true;
+            }
+            if (failed) {
+                qDebug() << "not starting" << name << ": a prerequisite is not running";
+                pending.remove(name);
+                continue;
+            }
+            if (blocked)
+                continue;
+            pending.remove(name);
+            if (node.item->state() == QProcess::NotRunning && !node.item->isQueued())
+                node.item->start();
+        }
+    } while (repump);
+    pumping = false;
+}
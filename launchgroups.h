@@ -0,0 +1,57 @@
+#ifndef LAUNCHGROUPS_H
+#define LAUNCHGROUPS_H
+
+#include <QObject>
+#include <QHash>
+#include <QSet>
+#include <QStringList>
+
+class LaunchEntry;
+
+// Dependency graph between named entries. Starting a group pulls in the
+// transitive prerequisites of its members and launches every entry as
+// soon as all of its prerequisites are ready, so independent branches of
+// the DAG start concurrently.
+class LaunchGroups : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit LaunchGroups(QObject *parent = nullptr);
+
+    bool addItem(const QString& name,
+                 LaunchEntry *item,
+                 const QStringList& depends,
+                 const QStringList& groups);
+    // Drops unknown dependencies and breaks dependency cycles, which are
+    // returned one list of entries per cycle
+    QList<QStringList> resolve();
+
+    QStringList groups() const;
+    LaunchEntry *item(const QString& name) const;
+    QStringList names() const { return order; }
+
+public slots:
+    void startGroup(const QString& group);
+    void startWithDependencies(const QString& name);
+
+private:
+    void watchPrerequisites();
+    void schedule(const QString& name);
+    void pump();
+
+    struct Node {
+        LaunchEntry *item;
+        QStringList depends;
+        QStringList groups;
+    };
+
+    QHash<QString, Node> nodes;
+    QStringList insertion;
+    QStringList order;
+    QSet<QString> pending;
+    bool pumping;
+    bool repump;
+};
+
+#endif // LAUNCHGROUPS_H
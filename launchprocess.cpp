@@ -0,0 +1,267 @@
+#include "launchprocess.h"
+#include "cgroupfreezer.h"
+
+#ifdef Q_OS_UNIX
+#include "detachedprocess.h"
+#include "spawnprocess.h"
+#endif
+
+#include <QFile>
+
+#include <QtDebug>
+
+#ifdef Q_OS_UNIX
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+constexpr auto LOW_PRIORITY_NICE = 19;
+
+qint64 LaunchProcess::residentKiB()
+{
+#ifdef Q_OS_LINUX
+    QFile f{"/proc/self/statm"};
+    if (!f.open(QFile::ReadOnly))
+        return -1;
+    auto fields = f.readAll().split(' ');
+    if (fields.size() < 2)
+        return -1;
+    return fields.at(1).toLongLong() * ::sysconf(_SC_PAGESIZE) / 1024;
+#else
+    return -1;
+#endif
+}
+
+#ifdef Q_OS_UNIX
+// Puts the child in its own process group, as SpawnProcess does
+class GroupProcess : public QProcess
+{
+public:
+    explicit GroupProcess(QObject *parent = nullptr)
+        : QProcess{parent}
+    {
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+        setChildProcessModifier([]() { ::setpgid(0, 0); });
+#endif
+    }
+
+#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
+protected:
+    // deprecated in 5.15 for setChildProcessModifier(), which only comes
+    // with Qt 6: the only way to run code in the child on Qt 5
+QT_WARNING_PUSH
+QT_WARNING_DISABLE_DEPRECATED
+    void setupChildProcess() override { ::setpgid(0, 0); }
+QT_WARNING_POP
+#endif
+};
+#else
+using GroupProcess = QProcess;
+#endif
+
+class QtLaunchProcess : public LaunchProcess
+{
+public:
+    explicit QtLaunchProcess(QObject *parent)
+        : LaunchProcess{parent},
+          proc{new GroupProcess{this}}
+    {
+        connect(proc, &QProcess::stateChanged, this, &LaunchProcess::stateChanged);
+        connect(proc, &QProcess::started, this, [this]() {
+            endSpawnMeasure("qprocess");
+            emit started();
+        });
+        connect(proc, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
+                this, &LaunchProcess::finished);
+        connect(proc, &QProcess::errorOccurred, this, &LaunchProcess::errorOccurred);
+        connect(proc, &QProcess::readyReadStandardOutput, this, &LaunchProcess::readyReadStandardOutput);
+        connect(proc, &QProcess::readyReadStandardError, this, &LaunchProcess::readyReadStandardError);
+    }
+
+    void setWorkingDirectory(const QString& dir) override { proc->setWorkingDirectory(dir); }
+    void setProcessEnvironment(const QProcessEnvironment& env) override { proc->setProcessEnvironment(env); }
+
+    QProcess::ProcessState state() const override { return proc->state(); }
+    qint64 processId() const override { return proc->processId(); }
+
+    QByteArray readAllStandardOutput() override { return proc->readAllStandardOutput(); }
+    QByteArray readAllStandardError() override { return proc->readAllStandardError(); }
+
+    void start(const QString& program, const QStringList& arguments) override
+    {
+        beginSpawnMeasure();
+        proc->start(program, arguments);
+        // the child is forked before start() returns, exec is reported
+        // later through started()
+        if (proc->state() != QProcess::NotRunning)
+            markExec();
+    }
+
+    void terminate() override { proc->terminate(); }
+
+private:
+    QProcess *proc;
+};
+
+LaunchProcess::LaunchProcess(QObject *parent)
+    : QObject{parent},
+      cgroup{nullptr},
+      frozen{false},
+      lowPriority{false},
+      savedNice{0}
+{
+    connect(this, &LaunchProcess::started, this, [this]() {
+        resetFreezer();
+        if (CgroupFreezer::isAvailable()) {
+            cgroup = new CgroupFreezer{processId()};
+            if (!cgroup->isValid())
+                resetFreezer();
+        }
+    });
+    connect(this, &LaunchProcess::stateChanged, this, [this](QProcess::ProcessState state) {
+        if (state == QProcess::NotRunning) {
+            resetFreezer();
+            lowPriority = false;
+        }
+    });
+}
+
+LaunchProcess::~LaunchProcess()
+{
+    delete cgroup;
+}
+
+void LaunchProcess::resetFreezer()
+{
+    delete cgroup;
+    cgroup = nullptr;
+    if (frozen) {
+        frozen = false;
+        emit frozenChanged(false);
+    }
+}
+
+void LaunchProcess::setChildRegistry(ChildRegistry *registry, const QString &key)
+{
+    Q_UNUSED(registry)
+    Q_UNUSED(key)
+}
+
+#ifdef Q_OS_UNIX
+// Process group of the application, or 0 when it shares ours (setpgid()
+// failed) and signalling the group would hit the launcher too
+static pid_t processGroup(pid_t pid)
+{
+    auto group = ::getpgid(pid);
+    return group > 0 && group != ::getpgrp()? group : 0;
+}
+#endif
+
+bool LaunchProcess::setFrozen(bool freeze)
+{
+    if (frozen == freeze || state() != QProcess::Running)
+        return false;
+#ifdef Q_OS_UNIX
+    bool ok = false;
+    if (cgroup) {
+        ok = cgroup->setFrozen(freeze);
+    } else {
+        auto pid = pid_t(processId());
+        auto group = processGroup(pid);
+        auto sig = freeze? SIGSTOP : SIGCONT;
+        ok = (group && ::kill(-group, sig) == 0) || ::kill(pid, sig) == 0;
+    }
+    if (!ok) {
+        qWarning() << "cannot" << (freeze? "freeze" : "thaw") << "process" << processId();
+        return false;
+    }
+    frozen = freeze;
+    emit frozenChanged(frozen);
+    return true;
+#else
+    Q_UNUSED(freeze)
+    return false;
+#endif
+}
+
+bool LaunchProcess::setLowPriority(bool low)
+{
+    if (lowPriority == low || state() != QProcess::Running)
+        return false;
+#ifdef Q_OS_UNIX
+    auto pid = id_t(processId());
+    if (low) {
+        errno = 0;
+        auto nice = ::getpriority(PRIO_PROCESS, pid);
+        if (nice == -1 && errno != 0)
+            return false;
+        savedNice = nice;
+    }
+    auto nice = low? LOW_PRIORITY_NICE : savedNice;
+    // raising the priority back needs RLIMIT_NICE headroom (or privileges)
+    auto group = id_t(processGroup(pid_t(pid)));
+    if ((!group || ::setpriority(PRIO_PGRP, group, nice) != 0)
+            && ::setpriority(PRIO_PROCESS, pid, nice) != 0) {
+        qWarning() << "cannot renice process" << pid << "to" << nice << ::strerror(errno);
+        return false;
+    }
+    lowPriority = low;
+    return true;
+#else
+    Q_UNUSED(low)
+    return false;
+#endif
+}
+
+LaunchProcess *LaunchProcess::create(Backend backend, QObject *parent)
+{
+#ifdef Q_OS_UNIX
+    if (backend == SpawnBackend)
+        return new SpawnProcess{parent};
+    if (backend == DetachedBackend)
+        return new DetachedProcess{parent};
+#else
+    Q_UNUSED(backend)
+#endif
+    return new QtLaunchProcess{parent};
+}
+
+LaunchProcess::Backend LaunchProcess::backendFromName(const QString &name, Backend fallback)
+{
+    if (name == "qprocess")
+        return QProcessBackend;
+    if (name == "spawn")
+        return SpawnBackend;
+    if (!name.isEmpty())
+        qDebug() << "unknown spawn backend" << name;
+    return fallback;
+}
+
+void LaunchProcess::beginSpawnMeasure()
+{
+    spawnTimer.start();
+    execTimer.invalidate();
+}
+
+void LaunchProcess::endSpawnMeasure(const char *backend)
+{
+    if (!spawnTimer.isValid())
+        return;
+    qDebug() << "spawn" << backend << "latency"
+             << spawnTimer.nsecsElapsed() / 1000 << "us"
+             << "rss" << residentKiB() << "KiB";
+    spawnTimer.invalidate();
+}
+
+void LaunchProcess::markExec()
+{
+    execTimer.start();
+}
+
+qint64 LaunchProcess::nsecsSinceExec() const
+{
+    return execTimer.isValid()? execTimer.nsecsElapsed() : -1;
+}
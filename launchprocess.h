@@ -0,0 +1,83 @@
+#ifndef LAUNCHPROCESS_H
+#define LAUNCHPROCESS_H
+
+#include <QObject>
+#include <QProcess>
+#include <QElapsedTimer>
+
+class CgroupFreezer;
+class ChildRegistry;
+
+class LaunchProcess : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Backend {
+        QProcessBackend,
+        SpawnBackend,
+        DetachedBackend,
+    };
+
+    static LaunchProcess *create(Backend backend, QObject *parent = nullptr);
+    static Backend backendFromName(const QString& name, Backend fallback = QProcessBackend);
+    // Resident set size of the launcher, -1 where unknown
+    static qint64 residentKiB();
+
+    // Only detached processes outlive the launcher and need to be recorded
+    virtual void setChildRegistry(ChildRegistry *registry, const QString& key);
+
+    virtual void setWorkingDirectory(const QString& dir) = 0;
+    virtual void setProcessEnvironment(const QProcessEnvironment& env) = 0;
+
+    virtual QProcess::ProcessState state() const = 0;
+    virtual qint64 processId() const = 0;
+
+    virtual QByteArray readAllStandardOutput() = 0;
+    virtual QByteArray readAllStandardError() = 0;
+
+    // Stops or resumes the whole process group of the application (or its
+    // cgroup when the launcher may create one)
+    bool setFrozen(bool freeze);
+    bool isFrozen() const { return frozen; }
+    // Renices the process group to the lowest priority, and back
+    bool setLowPriority(bool low);
+
+    // Time since the backend forked or spawned the child of the current
+    // launch, -1 before that
+    qint64 nsecsSinceExec() const;
+
+public slots:
+    virtual void start(const QString& program, const QStringList& arguments) = 0;
+    virtual void terminate() = 0;
+
+signals:
+    void stateChanged(QProcess::ProcessState state);
+    void started();
+    void finished(int exitCode, QProcess::ExitStatus exitStatus);
+    void errorOccurred(QProcess::ProcessError error);
+    void readyReadStandardOutput();
+    void readyReadStandardError();
+    void frozenChanged(bool frozen);
+
+protected:
+    explicit LaunchProcess(QObject *parent = nullptr);
+    ~LaunchProcess() override;
+
+    void beginSpawnMeasure();
+    void endSpawnMeasure(const char *backend);
+    // Called right after fork()/posix_spawn() returned in the launcher
+    void markExec();
+
+private:
+    void resetFreezer();
+
+    QElapsedTimer spawnTimer;
+    QElapsedTimer execTimer;
+    CgroupFreezer *cgroup;
+    bool frozen;
+    bool lowPriority;
+    int savedNice;
+};
+
+#endif // LAUNCHPROCESS_H
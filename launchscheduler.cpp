@@ -0,0 +1,135 @@
+#include "launchscheduler.h"
+#include "launchentry.h"
+
+#include <QtDebug>
+
+LaunchScheduler::LaunchScheduler(int maxConcurrent,
+                                 const QHash<QString, int> &groupLimits,
+                                 QObject *parent)
+    : QObject{parent},
+      maxConcurrent{maxConcurrent},
+      groupLimits{groupLimits},
+      dispatching{false},
+      redispatch{false}
+{
+}
+
+static int lowerLimit(int a, int b)
+{
+    // 0 or less means no limit
+    if (a <= 0)
+        return b;
+    if (b <= 0)
+        return a;
+    return qMin(a, b);
+}
+
+void LaunchScheduler::addLimits(int max, const QHash<QString, int> &limits)
+{
+    maxConcurrent = lowerLimit(maxConcurrent, max);
+    for (auto it = limits.constBegin(); it != limits.constEnd(); ++it)
+        groupLimits.insert(it.key(), lowerLimit(groupLimits.value(it.key()), it.value()));
+}
+
+void LaunchScheduler::addItem(LaunchEntry *item, int priority, const QStringList &groups)
+{
+    if (entries.contains(item))
+        return;
+    entries.insert(item, Entry{priority, groups});
+    connect(item, &LaunchEntry::stateChange, this, [this, item]() { itemStateChanged(item); });
+    connect(item, &QObject::destroyed, this, [this, item]() {
+        entries.remove(item);
+        queue.removeAll(item);
+        active.remove(item);
+        updatePositions();
+        dispatch();
+    });
+    itemStateChanged(item);
+}
+
+void LaunchScheduler::request(LaunchEntry *item)
+{
+    if (!entries.contains(item)) {
+        item->spawn();
+        return;
+    }
+    if (queue.contains(item) || active.contains(item))
+        return;
+    // highest priority first, FIFO between equals
+    auto priority = entries.value(item).priority;
+    auto it = queue.begin();
+    while (it != queue.end() && entries.value(*it).priority >= priority)
+        ++it;
+    queue.insert(it, item);
+    updatePositions();
+    dispatch();
+}
+
+void LaunchScheduler::cancel(LaunchEntry *item)
+{
+    if (queue.removeAll(item)) {
+        item->setQueuePosition(0);
+        updatePositions();
+    }
+}
+
+void LaunchScheduler::itemStateChanged(LaunchEntry *item)
+{
+    if (item->state() == QProcess::NotRunning) {
+        if (active.remove(item))
+            dispatch();
+    } else {
+        active.insert(item);
+    }
+}
+
+bool LaunchScheduler::canStart(LaunchEntry *item) const
+{
+    if (maxConcurrent > 0 && active.size() >= maxConcurrent)
+        return false;
+    for (const auto& g: entries.value(item).groups) {
+        auto limit = groupLimits.value(g, 0);
+        if (limit <= 0)
+            continue;
+        int running = 0;
+        for (auto a: active)
+            if (entries.value(a).groups.contains(g))
+                running++;
+        if (running >= limit)
+            return false;
+    }
+    return true;
+}
+
+void LaunchScheduler::dispatch()
+{
+    // spawning reports the new state synchronously, which lands back here
+    if (dispatching) {
+        redispatch = true;
+        return;
+    }
+    dispatching = true;
+    do {
+        redispatch = false;
+        for (int i = 0; i < queue.size(); ) {
+            auto item = queue.at(i);
+            if (!canStart(item)) {
+                i++;
+                continue;
+            }
+            queue.removeAt(i);
+            item->setQueuePosition(0);
+            item->spawn();
+            if (maxConcurrent > 0 && active.size() >= maxConcurrent)
+                break;
+        }
+    } while (redispatch);
+    dispatching = false;
+    updatePositions();
+}
+
+void LaunchScheduler::updatePositions()
+{
+    for (int i = 0; i < queue.size(); i++)
+        queue.at(i)->setQueuePosition(i + 1);
+}
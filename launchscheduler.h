@@ -0,0 +1,54 @@
+#ifndef LAUNCHSCHEDULER_H
+#define LAUNCHSCHEDULER_H
+
+#include <QObject>
+#include <QHash>
+#include <QSet>
+#include <QStringList>
+
+class LaunchEntry;
+
+// Sits between LaunchEntry::start() and the real spawn. Keeps the number
+// of starting or running processes under a global and a per group limit
+// and queues the excess launch requests by priority. One scheduler serves
+// every configuration of the launcher, so the limits hold for all of them.
+class LaunchScheduler : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit LaunchScheduler(int maxConcurrent = 0,
+                             const QHash<QString, int>& groupLimits = {},
+                             QObject *parent = nullptr);
+
+    // Merges the limits of one more configuration: the lowest limit wins
+    void addLimits(int maxConcurrent, const QHash<QString, int>& groupLimits);
+
+    // Registers an entry, again is a no-op: entries register when they
+    // first start, so the idle ones cost nothing here
+    void addItem(LaunchEntry *item, int priority, const QStringList& groups);
+
+    void request(LaunchEntry *item);
+    void cancel(LaunchEntry *item);
+
+private:
+    void itemStateChanged(LaunchEntry *item);
+    bool canStart(LaunchEntry *item) const;
+    void dispatch();
+    void updatePositions();
+
+    struct Entry {
+        int priority;
+        QStringList groups;
+    };
+
+    int maxConcurrent;
+    QHash<QString, int> groupLimits;
+    QHash<LaunchEntry *, Entry> entries;
+    QList<LaunchEntry *> queue;
+    QSet<LaunchEntry *> active;
+    bool dispatching;
+    bool redispatch;
+};
+
+#endif // LAUNCHSCHEDULER_H
@@ -0,0 +1,219 @@
+#include "launchstats.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QTimer>
+
+#include <QtDebug>
+
+constexpr auto SUB_BUCKET_BITS = 4;
+constexpr auto SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+constexpr auto STATS_NAME = "launch-stats.json";
+constexpr auto SAVE_DELAY = 2000;
+constexpr auto PREFETCHED_SUFFIX = ".prefetched";
+
+static const char *const PHASE_NAMES[LaunchStats::PhaseCount] = {
+    "exec", "running", "output"
+};
+
+static const char *const PHASE_LABELS[LaunchStats::PhaseCount] = {
+    QT_TRANSLATE_NOOP("LaunchStats", "Exec"),
+    QT_TRANSLATE_NOOP("LaunchStats", "Running"),
+    QT_TRANSLATE_NOOP("LaunchStats", "First output"),
+};
+
+static int highestBit(quint64 v)
+{
+    int n = -1;
+    while (v) {
+        v >>= 1;
+        n++;
+    }
+    return n;
+}
+
+int LatencyHistogram::bucketOf(qint64 value)
+{
+    if (value < SUB_BUCKETS)
+        return int(qMax<qint64>(value, 0));
+    auto m = highestBit(quint64(value));
+    auto sub = int(value >> (m - SUB_BUCKET_BITS)) & (SUB_BUCKETS - 1);
+    return (m - SUB_BUCKET_BITS + 1) * SUB_BUCKETS + sub;
+}
+
+qint64 LatencyHistogram::valueOf(int bucket)
+{
+    if (bucket < SUB_BUCKETS)
+        return bucket;
+    auto m = bucket / SUB_BUCKETS + SUB_BUCKET_BITS - 1;
+    auto sub = bucket % SUB_BUCKETS;
+    auto shift = m - SUB_BUCKET_BITS;
+    auto low = qint64(SUB_BUCKETS + sub) << shift;
+    // middle of the bucket
+    return low + ((qint64(1) << shift) >> 1);
+}
+
+void LatencyHistogram::record(qint64 value)
+{
+    auto b = bucketOf(value);
+    if (b >= counts.size())
+        counts.resize(b + 1);
+    counts[b]++;
+    total++;
+}
+
+qint64 LatencyHistogram::percentile(double p) const
+{
+    if (total == 0)
+        return -1;
+    auto wanted = qMax<qint64>(1, qint64(p / 100.0 * total + 0.5));
+    qint64 seen = 0;
+    for (int b = 0; b < counts.size(); b++) {
+        seen += counts.at(b);
+        if (seen >= wanted)
+            return valueOf(b);
+    }
+    return valueOf(counts.size() - 1);
+}
+
+QJsonObject LatencyHistogram::toJson() const
+{
+    QJsonObject o;
+    for (int b = 0; b < counts.size(); b++)
+        if (counts.at(b))
+            o.insert(QString::number(b), qint64(counts.at(b)));
+    return o;
+}
+
+LatencyHistogram LatencyHistogram::fromJson(const QJsonObject &o)
+{
+    LatencyHistogram h;
+    for (auto it = o.constBegin(); it != o.constEnd(); ++it) {
+        bool ok = false;
+        auto b = it.key().toInt(&ok);
+        auto n = it.value().toInt();
+        if (!ok || b < 0 || n <= 0)
+            continue;
+        if (b >= h.counts.size())
+            h.counts.resize(b + 1);
+        h.counts[b] += quint32(n);
+        h.total += n;
+    }
+    return h;
+}
+
+LaunchStats::LaunchStats(const QString &stateFile, QObject *parent)
+    : QObject{parent},
+      fileName{stateFile},
+      saveTimer{new QTimer{this}}
+{
+    saveTimer->setSingleShot(true);
+    saveTimer->setInterval(SAVE_DELAY);
+    connect(saveTimer, &QTimer::timeout, this, &LaunchStats::save);
+    load();
+}
+
+LaunchStats::~LaunchStats()
+{
+    if (saveTimer->isActive())
+        save();
+}
+
+// Launches that follow a page cache prefetch are kept in their own
+// histograms, stored after the PhaseCount cold ones.
+static int slotOf(int phase, bool prefetched)
+{
+    return prefetched? phase + LaunchStats::PhaseCount : phase;
+}
+
+static QString slotName(int slot)
+{
+    auto phase = slot % LaunchStats::PhaseCount;
+    return slot >= LaunchStats::PhaseCount?
+                QString{PHASE_NAMES[phase]} + PREFETCHED_SUFFIX : QString{PHASE_NAMES[phase]};
+}
+
+void LaunchStats::record(const QString &app, Phase phase, qint64 usecs, bool prefetched)
+{
+    auto& h = apps[app];
+    if (h.size() < PhaseCount * 2)
+        h.resize(PhaseCount * 2);
+    h[slotOf(phase, prefetched)].record(usecs);
+    qDebug() << "launch" << app << PHASE_NAMES[phase] << (prefetched? "prefetched" : "cold") << usecs << "us";
+    saveTimer->start();
+    emit updated(app);
+}
+
+QString LaunchStats::summary(const QString &app) const
+{
+    auto it = apps.constFind(app);
+    if (it == apps.constEnd())
+        return {};
+    QStringList lines;
+    for (int p = 0; p < it->size(); p++) {
+        const auto& h = it->at(p);
+        if (h.count() == 0)
+            continue;
+        auto label = tr(PHASE_LABELS[p % PhaseCount]);
+        if (p >= PhaseCount)
+            label = tr("%1 (prefetched)").arg(label);
+        lines.append(tr("%1: p50 %2 ms, p95 %3 ms (%4 launches)")
+                     .arg(label)
+                     .arg(h.percentile(50) / 1000.0, 0, 'f', 1)
+                     .arg(h.percentile(95) / 1000.0, 0, 'f', 1)
+                     .arg(h.count()));
+    }
+    return lines.join('\n');
+}
+
+QString LaunchStats::defaultStateFile()
+{
+    auto dir = QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation);
+    return QDir{dir}.filePath(STATS_NAME);
+}
+
+void LaunchStats::load()
+{
+    QFile f{fileName};
+    if (!f.open(QFile::ReadOnly))
+        return;
+    QJsonParseError err;
+    auto doc = QJsonDocument::fromJson(f.readAll(), &err).object();
+    if (err.error != QJsonParseError::NoError) {
+        qDebug() << "Error loading " << fileName << ": " << err.errorString();
+        return;
+    }
+    for (auto it = doc.constBegin(); it != doc.constEnd(); ++it) {
+        auto phases = it.value().toObject();
+        QVector<LatencyHistogram> h(PhaseCount * 2);
+        for (int p = 0; p < h.size(); p++)
+            h[p] = LatencyHistogram::fromJson(phases.value(slotName(p)).toObject());
+        apps.insert(it.key(), h);
+    }
+}
+
+void LaunchStats::save()
+{
+    QJsonObject doc;
+    for (auto it = apps.constBegin(); it != apps.constEnd(); ++it) {
+        QJsonObject phases;
+        for (int p = 0; p < it->size(); p++)
+            if (it->at(p).count())
+                phases.insert(slotName(p), it->at(p).toJson());
+        doc.insert(it.key(), phases);
+    }
+    QDir{}.mkpath(QFileInfo{fileName}.absolutePath());
+    QSaveFile f{fileName};
+    if (!f.open(QFile::WriteOnly)) {
+        qDebug() << "file error: " << fileName << "\n" << f.errorString();
+        return;
+    }
+    f.write(QJsonDocument{doc}.toJson(QJsonDocument::Compact));
+    f.commit();
+}
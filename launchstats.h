@@ -0,0 +1,64 @@
+#ifndef LAUNCHSTATS_H
+#define LAUNCHSTATS_H
+
+#include <QObject>
+#include <QHash>
+#include <QVector>
+
+class QTimer;
+class QJsonObject;
+
+// Log-linear latency histogram in the spirit of HdrHistogram: every power
+// of two is split in SUB_BUCKETS linear buckets, so any recorded value is
+// kept with ~6% relative precision in a few hundred counters.
+class LatencyHistogram
+{
+public:
+    void record(qint64 value);
+    qint64 percentile(double p) const;
+    qint64 count() const { return total; }
+
+    QJsonObject toJson() const;
+    static LatencyHistogram fromJson(const QJsonObject& o);
+
+private:
+    static int bucketOf(qint64 value);
+    static qint64 valueOf(int bucket);
+
+    QVector<quint32> counts;
+    qint64 total = 0;
+};
+
+class LaunchStats : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Phase {
+        Exec,
+        Running,
+        FirstOutput,
+        PhaseCount
+    };
+
+    explicit LaunchStats(const QString& stateFile, QObject *parent = nullptr);
+    ~LaunchStats() override;
+
+    void record(const QString& app, Phase phase, qint64 usecs, bool prefetched = false);
+    QString summary(const QString& app) const;
+
+    static QString defaultStateFile();
+
+signals:
+    void updated(const QString& app);
+
+private:
+    void load();
+    void save();
+
+    QString fileName;
+    QHash<QString, QVector<LatencyHistogram>> apps;
+    QTimer *saveTimer;
+};
+
+#endif // LAUNCHSTATS_H
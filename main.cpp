@@ -1,12 +1,131 @@
 #include "MainWidget.h"
+#include "controlclient.h"
+#include "launcherengine.h"
+#include "launcherhost.h"
+#include "remotewidget.h"
 
 #include <QApplication>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QSocketNotifier>
+#include <qtlocalpeer.h>
+
+#include <QtDebug>
+
+#ifdef Q_OS_UNIX
+#include <csignal>
+#include <sys/socket.h>
+#include <unistd.h>
+
+static int signalFd[2] = { -1, -1 };
+
+static void quitOnSignal(int)
+{
+    char c = 1;
+    if (::write(signalFd[0], &c, sizeof(c)) < 0) {
+        // nothing to do about it in a signal handler
+    }
+}
+#endif
+
+// Configuration files given on the command line
+static QStringList configArguments(int argc, char *argv[])
+{
+    QStringList files;
+    for (int i = 1; i < argc; i++) {
+        QFileInfo f{QString::fromLocal8Bit(argv[i])};
+        if (argv[i][0] != '-' && f.isFile())
+            files.append(f.absoluteFilePath());
+    }
+    return files;
+}
+
+// Runs the configurations without any GUI: no display connection, the
+// entries are driven through the control protocol (--ctl)
+static int runDaemon(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+
+    auto files = configArguments(argc, argv);
+    QtLocalPeer peer{nullptr, LauncherEngine::configurationFile()};
+    if (peer.isClient()) {
+        qWarning() << "Another instance is running";
+        return 1;
+    }
+    // there is no window to show: the GUI asking for it attaches to this
+    // instance as a remote front-end instead
+    peer.refuseMessage("maximize");
+
+    LauncherHost host;
+    host.serve(&peer);
+    if (files.isEmpty())
+        files.append(LauncherEngine::configurationFile());
+    for (const auto& f: qAsConst(files))
+        host.open(f);
+
+#ifdef Q_OS_UNIX
+    // quit through the event loop so the children are stopped as on exit
+    if (::socketpair(AF_UNIX, SOCK_STREAM, 0, signalFd) == 0) {
+        auto notifier = new QSocketNotifier{signalFd[1], QSocketNotifier::Read, &a};
+        QObject::connect(notifier, SIGNAL(activated(int)), &a, SLOT(quit()));
+        std::signal(SIGTERM, quitOnSignal);
+        std::signal(SIGINT, quitOnSignal);
+        std::signal(SIGHUP, quitOnSignal);
+    }
+#endif
+    qDebug() << "running" << host.engines().size() << "configurations headless";
+    return a.exec();
+}
+
+// The window of a headless instance, driving it through the control
+// protocol
+static int runRemote(const QString& instanceId)
+{
+    RemoteWidget w{instanceId};
+    if (!w.isAttached()) {
+        qWarning() << "cannot attach to the headless instance";
+        return 1;
+    }
+    w.show();
+    return QApplication::exec();
+}
 
 int main(int argc, char *argv[])
 {
+    QElapsedTimer started;
+    started.start();
+    if (argc > 1 && qstrcmp(argv[1], "--ctl") == 0) {
+        QStringList args;
+        for (int i = 2; i < argc; i++)
+            args.append(QString::fromLocal8Bit(argv[i]));
+        return runControl(LauncherEngine::configurationFile(), args);
+    }
+    if (argc > 1 && qstrcmp(argv[1], "--daemon") == 0)
+        return runDaemon(argc, argv);
+
+    // Already running: hand over before paying for the GUI initialization
+    QElapsedTimer roundTrip;
+    roundTrip.start();
+    auto instanceId = LauncherEngine::configurationFile();
+    auto files = configArguments(argc, argv);
+    auto message = files.isEmpty()? QString{"maximize"} : LauncherHost::openMessage(files.first());
+    bool headless = false;
+    if (QtLocalPeer::sendMessageDirect(instanceId, message, 1000, &headless)) {
+        for (const auto& f: files.mid(1))
+            QtLocalPeer::sendMessageDirect(instanceId, LauncherHost::openMessage(f), 1000);
+        qDebug() << "handover round trip" << roundTrip.nsecsElapsed() / 1000 << "us";
+        return 0;
+    }
+    if (headless) {
+        QApplication a(argc, argv);
+        return runRemote(instanceId);
+    }
+
     QApplication a(argc, argv);
 
-    Widget w;
+    Widget w{files, started};
+    if (w.property("headlessOwner").toBool())
+        return runRemote(instanceId);
     if (w.property("isClient").toBool())
         return 0;
     w.show();
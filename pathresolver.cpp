@@ -0,0 +1,40 @@
+#include "pathresolver.h"
+
+#include <QDir>
+#include <QFileInfo>
+#include <QFileSystemWatcher>
+#include <QStandardPaths>
+
+#include <QtDebug>
+
+PathResolver::PathResolver(const QStringList &dirs, QObject *parent)
+    : QObject{parent},
+      watcher{new QFileSystemWatcher{this}}
+{
+    for (const auto& d: dirs) {
+        if (d.isEmpty() || searchDirs.contains(d))
+            continue;
+        searchDirs.append(d);
+        if (QFileInfo{d}.isDir())
+            watcher->addPath(d);
+    }
+    connect(watcher, &QFileSystemWatcher::directoryChanged, this, [this](const QString& dir) {
+        qDebug() << "PATH entry" << dir << "changed, flushing resolved commands";
+        cache.clear();
+        emit changed();
+    });
+}
+
+QString PathResolver::resolve(const QString &program, const QString &workdir)
+{
+    if (program.contains('/') || program.contains(QDir::separator())) {
+        QFileInfo info{QDir{workdir}, program};
+        return info.isFile() && info.isExecutable()? info.absoluteFilePath() : QString{};
+    }
+    auto it = cache.constFind(program);
+    if (it != cache.constEnd())
+        return *it;
+    auto path = QStandardPaths::findExecutable(program, searchDirs);
+    cache.insert(program, path);
+    return path;
+}
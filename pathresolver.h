@@ -0,0 +1,31 @@
+#ifndef PATHRESOLVER_H
+#define PATHRESOLVER_H
+
+#include <QObject>
+#include <QHash>
+#include <QStringList>
+
+class QFileSystemWatcher;
+
+// Resolves bare program names against the launcher PATH once and caches
+// the absolute result. The PATH directories are watched, so the cache is
+// dropped as soon as something is installed or removed there.
+class PathResolver : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit PathResolver(const QStringList& dirs, QObject *parent = nullptr);
+
+    QString resolve(const QString& program, const QString& workdir = {});
+
+signals:
+    void changed();
+
+private:
+    QStringList searchDirs;
+    QHash<QString, QString> cache;
+    QFileSystemWatcher *watcher;
+};
+
+#endif // PATHRESOLVER_H
@@ -0,0 +1,79 @@
+#include "patternmatcher.h"
+
+#include <QQueue>
+
+constexpr auto ALPHABET = 256;
+
+int PatternMatcher::newState()
+{
+    delta.resize(delta.size() + ALPHABET);
+    std::fill(delta.end() - ALPHABET, delta.end(), -1);
+    fail.append(0);
+    outputs.append(QVector<int>{});
+    return outputs.size() - 1;
+}
+
+int PatternMatcher::addPattern(const QByteArray &pattern)
+{
+    if (outputs.isEmpty())
+        newState();
+    int s = 0;
+    for (auto c: pattern) {
+        auto i = s * ALPHABET + uchar(c);
+        if (delta.at(i) < 0) {
+            auto n = newState();
+            delta[i] = n;
+        }
+        s = delta.at(i);
+    }
+    auto id = patternCount++;
+    outputs[s].append(id);
+    return id;
+}
+
+void PatternMatcher::compile()
+{
+    if (outputs.isEmpty())
+        newState();
+    QQueue<int> queue;
+    for (int c = 0; c < ALPHABET; c++) {
+        auto& next = delta[c];
+        if (next < 0) {
+            next = 0;
+        } else {
+            fail[next] = 0;
+            queue.enqueue(next);
+        }
+    }
+    while (!queue.isEmpty()) {
+        auto s = queue.dequeue();
+        outputs[s].append(outputs.at(fail.at(s)));
+        for (int c = 0; c < ALPHABET; c++) {
+            auto& next = delta[s * ALPHABET + c];
+            auto viaFail = delta.at(fail.at(s) * ALPHABET + c);
+            if (next < 0) {
+                next = viaFail;
+            } else {
+                fail[next] = viaFail;
+                queue.enqueue(next);
+            }
+        }
+    }
+}
+
+QVector<int> PatternMatcher::scan(int &state, const QByteArray &chunk) const
+{
+    QVector<int> matches;
+    if (isEmpty())
+        return matches;
+    auto table = delta.constData();
+    auto s = state;
+    for (auto c: chunk) {
+        s = table[s * ALPHABET + uchar(c)];
+        const auto& out = outputs.at(s);
+        if (!out.isEmpty())
+            matches.append(out);
+    }
+    state = s;
+    return matches;
+}
@@ -0,0 +1,31 @@
+#ifndef PATTERNMATCHER_H
+#define PATTERNMATCHER_H
+
+#include <QByteArray>
+#include <QVector>
+
+// Aho-Corasick automaton over bytes compiled into a full DFA transition
+// table. All the patterns are searched in a single linear pass, and the
+// scan state is kept by the caller so matches spanning several chunks of
+// a stream are found.
+class PatternMatcher
+{
+public:
+    int addPattern(const QByteArray& pattern);
+    void compile();
+
+    bool isEmpty() const { return patternCount == 0; }
+
+    // Returns the ids of the patterns ending inside chunk, in stream order
+    QVector<int> scan(int& state, const QByteArray& chunk) const;
+
+private:
+    int newState();
+
+    QVector<int> delta;
+    QVector<int> fail;
+    QVector<QVector<int>> outputs;
+    int patternCount = 0;
+};
+
+#endif // PATTERNMATCHER_H
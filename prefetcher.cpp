@@ -0,0 +1,258 @@
+#include "prefetcher.h"
+
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QQueue>
+#include <QSet>
+#include <QThread>
+#include <QThreadPool>
+
+#include <QtDebug>
+
+#ifdef Q_OS_LINUX
+#include <cstring>
+#include <elf.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#ifdef Q_OS_LINUX
+
+struct ElfDeps
+{
+    QStringList needed;
+    QStringList rpath;
+    QStringList runpath;
+};
+
+static QString cString(const uchar *data, qint64 size, qint64 offset)
+{
+    if (offset < 0 || offset >= size)
+        return {};
+    auto s = reinterpret_cast<const char *>(data + offset);
+    return QFile::decodeName(QByteArray{s, int(qstrnlen(s, uint(size - offset)))});
+}
+
+template<typename Ehdr, typename Phdr, typename Dyn>
+static bool readDynamic(const uchar *data, qint64 size, ElfDeps& deps)
+{
+    if (size < qint64(sizeof(Ehdr)))
+        return false;
+    auto eh = reinterpret_cast<const Ehdr *>(data);
+    if (eh->e_phentsize != sizeof(Phdr)
+            || qint64(eh->e_phoff) + qint64(eh->e_phnum) * qint64(sizeof(Phdr)) > size)
+        return false;
+    auto ph = reinterpret_cast<const Phdr *>(data + eh->e_phoff);
+
+    const Phdr *dynamic = nullptr;
+    for (int i = 0; i < eh->e_phnum; i++)
+        if (ph[i].p_type == PT_DYNAMIC)
+            dynamic = &ph[i];
+    if (!dynamic)
+        return true; // static binary
+    if (qint64(dynamic->p_offset) + qint64(dynamic->p_filesz) > size)
+        return false;
+
+    auto fileOffset = [&](quint64 vaddr) -> qint64 {
+        for (int i = 0; i < eh->e_phnum; i++)
+            if (ph[i].p_type == PT_LOAD && vaddr >= ph[i].p_vaddr
+                    && vaddr < ph[i].p_vaddr + ph[i].p_filesz)
+                return qint64(vaddr - ph[i].p_vaddr + ph[i].p_offset);
+        return -1;
+    };
+
+    auto dyn = reinterpret_cast<const Dyn *>(data + dynamic->p_offset);
+    auto count = qint64(dynamic->p_filesz / sizeof(Dyn));
+    qint64 strtab = -1;
+    for (qint64 i = 0; i < count && dyn[i].d_tag != DT_NULL; i++)
+        if (dyn[i].d_tag == DT_STRTAB)
+            strtab = fileOffset(dyn[i].d_un.d_ptr);
+    if (strtab < 0)
+        return false;
+
+    for (qint64 i = 0; i < count && dyn[i].d_tag != DT_NULL; i++) {
+        auto str = [&]() { return cString(data, size, strtab + qint64(dyn[i].d_un.d_val)); };
+        switch (dyn[i].d_tag) {
+        case DT_NEEDED:
+            deps.needed.append(str());
+            break;
+        case DT_RPATH:
+            deps.rpath.append(str().split(':', Qt::SkipEmptyParts));
+            break;
+        case DT_RUNPATH:
+            deps.runpath.append(str().split(':', Qt::SkipEmptyParts));
+            break;
+        }
+    }
+    return true;
+}
+
+static bool readElfDeps(QFile& f, ElfDeps& deps)
+{
+    auto size = f.size();
+    auto data = f.map(0, size);
+    if (!data)
+        return false;
+    bool ok = false;
+    if (size >= EI_NIDENT && memcmp(data, ELFMAG, SELFMAG) == 0) {
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+        const auto hostData = ELFDATA2LSB;
+#else
+        const auto hostData = ELFDATA2MSB;
+#endif
+        if (data[EI_DATA] == hostData) {
+            if (data[EI_CLASS] == ELFCLASS64)
+                ok = readDynamic<Elf64_Ehdr, Elf64_Phdr, Elf64_Dyn>(data, size, deps);
+            else if (data[EI_CLASS] == ELFCLASS32)
+                ok = readDynamic<Elf32_Ehdr, Elf32_Phdr, Elf32_Dyn>(data, size, deps);
+        }
+    }
+    f.unmap(data);
+    return ok;
+}
+
+static void readLdConf(const QString& path, QStringList& dirs, int depth = 0)
+{
+    QFile f{path};
+    if (depth > 4 || !f.open(QFile::ReadOnly))
+        return;
+    while (!f.atEnd()) {
+        auto line = QString::fromLocal8Bit(f.readLine()).section('#', 0, 0).trimmed();
+        if (line.isEmpty())
+            continue;
+        if (line.startsWith("include ")) {
+            auto pattern = line.mid(8).trimmed();
+            if (QDir::isRelativePath(pattern))
+                pattern = QFileInfo{path}.absoluteDir().filePath(pattern);
+            QFileInfo info{pattern};
+            auto matches = QDir{info.absolutePath(), info.fileName()}.entryInfoList(QDir::Files, QDir::Name);
+            for (const auto& m: qAsConst(matches))
+                readLdConf(m.absoluteFilePath(), dirs, depth + 1);
+        } else {
+            dirs.append(line);
+        }
+    }
+}
+
+static const QStringList& systemLibraryDirs()
+{
+    static const QStringList dirs = []() {
+        QStringList d;
+        readLdConf("/etc/ld.so.conf", d);
+        d << "/lib64" << "/usr/lib64" << "/lib" << "/usr/lib";
+        d.removeDuplicates();
+        return d;
+    }();
+    return dirs;
+}
+
+static QStringList expandOrigin(const QStringList& dirs, const QString& origin)
+{
+    QStringList r;
+    for (auto d: dirs)
+        r.append(d.replace("$ORIGIN", origin).replace("${ORIGIN}", origin));
+    return r;
+}
+
+static QString findLibrary(const QString& name, const QList<QStringList>& searchLists)
+{
+    if (name.contains('/'))
+        return QFileInfo::exists(name)? name : QString{};
+    for (const auto& dirs: searchLists)
+        for (const auto& d: dirs) {
+            auto candidate = QDir{d}.filePath(name);
+            if (QFileInfo::exists(candidate))
+                return QFileInfo{candidate}.canonicalFilePath();
+        }
+    return {};
+}
+
+static qint64 warmFile(QFile& f)
+{
+    auto size = f.size();
+    auto fd = f.handle();
+    ::posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+    ::readahead(fd, 0, size_t(size));
+    return size;
+}
+
+#endif // Q_OS_LINUX
+
+Prefetcher::Prefetcher(QObject *parent)
+    : QObject{parent},
+      pool{new QThreadPool{this}}
+{
+    pool->setMaxThreadCount(1);
+}
+
+Prefetcher::~Prefetcher()
+{
+    pool->clear();
+    pool->waitForDone();
+}
+
+Prefetcher::Mode Prefetcher::modeFromName(const QString &name)
+{
+    if (name == "startup")
+        return Startup;
+    if (name == "hover")
+        return Hover;
+    if (!name.isEmpty() && name != "off")
+        qDebug() << "unknown prefetch mode" << name;
+    return Off;
+}
+
+void Prefetcher::prefetch(const QString &executable, const QStringList &libraryPath)
+{
+#ifdef Q_OS_LINUX
+    if (executable.isEmpty())
+        return;
+    pool->start([this, executable, libraryPath]() {
+        QThread::currentThread()->setPriority(QThread::IdlePriority);
+        QElapsedTimer t;
+        t.start();
+        QQueue<QString> pending;
+        QSet<QString> seen;
+        pending.enqueue(QFileInfo{executable}.canonicalFilePath());
+        qint64 bytes = 0;
+        while (!pending.isEmpty()) {
+            auto path = pending.dequeue();
+            if (path.isEmpty() || seen.contains(path))
+                continue;
+            seen.insert(path);
+            QFile f{path};
+            if (!f.open(QFile::ReadOnly))
+                continue;
+            bytes += warmFile(f);
+            ElfDeps deps;
+            if (!readElfDeps(f, deps))
+                continue;
+            auto origin = QFileInfo{path}.absolutePath();
+            QList<QStringList> search;
+            if (deps.runpath.isEmpty())
+                search.append(expandOrigin(deps.rpath, origin));
+            search.append(libraryPath);
+            search.append(expandOrigin(deps.runpath, origin));
+            search.append(systemLibraryDirs());
+            for (const auto& lib: qAsConst(deps.needed)) {
+                auto libPath = findLibrary(lib, search);
+                if (libPath.isEmpty())
+                    qDebug() << "prefetch:" << lib << "needed by" << path << "not found";
+                else
+                    pending.enqueue(libPath);
+            }
+        }
+        auto files = seen.size();
+        auto usecs = t.nsecsElapsed() / 1000;
+        QMetaObject::invokeMethod(this, [this, executable, files, bytes, usecs]() {
+            qDebug() << "prefetch" << executable << files << "files" << bytes / 1024 << "KiB in" << usecs << "us";
+            emit finished(executable, files, bytes, usecs);
+        }, Qt::QueuedConnection);
+    });
+#else
+    Q_UNUSED(executable)
+    Q_UNUSED(libraryPath)
+#endif
+}
@@ -0,0 +1,37 @@
+#ifndef PREFETCHER_H
+#define PREFETCHER_H
+
+#include <QObject>
+#include <QStringList>
+
+class QThreadPool;
+
+// Warms the page cache for an executable and every shared library it
+// needs (DT_NEEDED, followed recursively) on a low priority thread, so the
+// following launch does not pay the page faults on a cold cache.
+class Prefetcher : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Mode {
+        Off,
+        Startup,
+        Hover,
+    };
+
+    explicit Prefetcher(QObject *parent = nullptr);
+    ~Prefetcher() override;
+
+    static Mode modeFromName(const QString& name);
+
+    void prefetch(const QString& executable, const QStringList& libraryPath = {});
+
+signals:
+    void finished(const QString& executable, int files, qint64 bytes, qint64 usecs);
+
+private:
+    QThreadPool *pool;
+};
+
+#endif // PREFETCHER_H
@@ -0,0 +1,170 @@
+#include "pressuremonitor.h"
+
+#include <QFile>
+#include <QFileSystemWatcher>
+#include <QSocketNotifier>
+#include <QTimer>
+
+#include <QtDebug>
+
+#ifdef Q_OS_LINUX
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <linux/magic.h>
+#include <sys/vfs.h>
+#include <unistd.h>
+#endif
+
+// Quiet windows before the pressure is considered over
+constexpr auto CLEAR_WINDOWS = 5;
+constexpr auto MIN_CLEAR_MS = 10 * 1000;
+
+PressureMonitor::PressureMonitor(const QString &dir, QObject *parent)
+    : QObject{parent},
+      dir{dir},
+      fileWatcher{nullptr},
+      polling{false},
+      underPressure{false}
+{
+}
+
+PressureMonitor::~PressureMonitor()
+{
+#ifdef Q_OS_LINUX
+    for (const auto& w: qAsConst(watches))
+        if (w.fd >= 0)
+            ::close(w.fd);
+#endif
+}
+
+bool PressureMonitor::watch(const QString &resource, const QByteArray &trigger)
+{
+    const auto fields = trigger.simplified().split(' ');
+    bool ok1 = false;
+    bool ok2 = false;
+    auto stall = fields.value(1).toLongLong(&ok1);
+    auto window = fields.value(2).toLongLong(&ok2);
+    if (fields.size() != 3 || (fields.at(0) != "some" && fields.at(0) != "full")
+            || !ok1 || !ok2 || stall <= 0 || window <= 0 || stall > window) {
+        qWarning() << "invalid pressure trigger" << resource << trigger;
+        return false;
+    }
+    auto index = watches.size();
+    auto clearTimer = new QTimer{this};
+    clearTimer->setSingleShot(true);
+    clearTimer->setInterval(int(qMax<qint64>(CLEAR_WINDOWS * window / 1000, MIN_CLEAR_MS)));
+    connect(clearTimer, &QTimer::timeout, this, [this, index]() { setActive(index, false); });
+    watches.append(Watch{resource, fields.at(0), 100.0 * stall / window, -1, clearTimer, false});
+
+    auto path = dir + '/' + resource;
+#ifdef Q_OS_LINUX
+    int fd = ::open(QFile::encodeName(path).constData(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        qDebug() << "no pressure information in" << path;
+        return false;
+    }
+    struct statfs fs;
+    bool isProc = ::fstatfs(fd, &fs) == 0 && fs.f_type == PROC_SUPER_MAGIC;
+    ::close(fd);
+    if (isProc) {
+        fd = ::open(QFile::encodeName(path).constData(), O_RDWR | O_NONBLOCK | O_CLOEXEC);
+        auto t = fields.join(' ');
+        if (fd >= 0 && ::write(fd, t.constData(), size_t(t.size()) + 1) >= 0) {
+            watches[index].fd = fd;
+            // triggers are reported as POLLPRI
+            auto notifier = new QSocketNotifier{fd, QSocketNotifier::Exception, this};
+            connect(notifier, SIGNAL(activated(int)), this, SLOT(triggered(int)));
+            qDebug() << "watching" << path << "trigger" << t;
+            return true;
+        }
+        qDebug() << "cannot set pressure trigger on" << path << ::strerror(errno);
+        if (fd >= 0)
+            ::close(fd);
+    }
+#else
+    bool isProc = false;
+    if (!QFile::exists(path)) {
+        qDebug() << "no pressure information in" << path;
+        return false;
+    }
+#endif
+    if (!isProc) {
+        // not the kernel's file: read it again whenever it is rewritten
+        if (!fileWatcher) {
+            fileWatcher = new QFileSystemWatcher{this};
+            connect(fileWatcher, &QFileSystemWatcher::fileChanged, this, &PressureMonitor::fileChanged);
+        }
+        fileWatcher->addPath(path);
+        qDebug() << "watching" << path << "averages on change";
+        pollAverage(index);
+        return true;
+    }
+    if (!polling) {
+        qDebug() << "not watching" << path << ": pressure polling is off";
+        return false;
+    }
+    // unprivileged triggers need a recent kernel: fall back to the averages
+    qDebug() << "watching" << path << "averages every" << window / 1000 << "ms";
+    auto poll = new QTimer{this};
+    connect(poll, &QTimer::timeout, this, [this, index]() { pollAverage(index); });
+    poll->start(int(qMax<qint64>(window / 1000, 1000)));
+    return true;
+}
+
+void PressureMonitor::fileChanged(const QString &path)
+{
+    // a file replaced by a rename is dropped from the watcher
+    if (!fileWatcher->files().contains(path) && QFile::exists(path))
+        fileWatcher->addPath(path);
+    for (int i = 0; i < watches.size(); i++)
+        if (dir + '/' + watches.at(i).resource == path)
+            pollAverage(i);
+}
+
+void PressureMonitor::triggered(int fd)
+{
+    for (int i = 0; i < watches.size(); i++)
+        if (watches.at(i).fd == fd)
+            stalled(i);
+}
+
+void PressureMonitor::pollAverage(int index)
+{
+    const auto& w = watches.at(index);
+    QFile f{dir + '/' + w.resource};
+    if (!f.open(QFile::ReadOnly))
+        return;
+    // "some avg10=1.23 avg60=0.50 avg300=0.10 total=12345"
+    const auto lines = f.readAll().split('\n');
+    for (const auto& l: lines) {
+        const auto fields = l.split(' ');
+        if (fields.size() < 2 || fields.at(0) != w.kind || !fields.at(1).startsWith("avg10="))
+            continue;
+        if (fields.at(1).mid(6).toDouble() >= w.limit)
+            stalled(index);
+        break;
+    }
+}
+
+void PressureMonitor::stalled(int index)
+{
+    watches.at(index).clearTimer->start();
+    setActive(index, true);
+}
+
+void PressureMonitor::setActive(int index, bool active)
+{
+    auto& w = watches[index];
+    if (w.active == active)
+        return;
+    w.active = active;
+    qDebug() << w.resource << (active? "pressure" : "pressure cleared");
+    bool any = false;
+    for (const auto& x: qAsConst(watches))
+        any = any || x.active;
+    if (any != underPressure) {
+        underPressure = any;
+        emit pressureChanged(underPressure);
+    }
+}
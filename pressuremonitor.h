@@ -0,0 +1,58 @@
+#ifndef PRESSUREMONITOR_H
+#define PRESSUREMONITOR_H
+
+#include <QObject>
+#include <QVector>
+
+class QFileSystemWatcher;
+class QTimer;
+
+// Watches the kernel pressure stall information (PSI) of some resources.
+// Each resource gets a PSI trigger ("some 150000 2000000": 150ms of stall
+// in a 2s window) whose file descriptor wakes the event loop when it
+// fires. The pressure is over once no trigger fired for a few windows.
+// Files outside procfs (a test or container fake) are never written to:
+// their "avg10" averages are read again whenever the file changes.
+class PressureMonitor : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit PressureMonitor(const QString& dir = "/proc/pressure", QObject *parent = nullptr);
+    ~PressureMonitor() override;
+
+    // Reads the averages once per window where the kernel refuses the
+    // trigger, instead of giving up on the resource (off by default)
+    void setPolling(bool enabled) { polling = enabled; }
+    bool watch(const QString& resource, const QByteArray& trigger);
+    bool isUnderPressure() const { return underPressure; }
+
+signals:
+    void pressureChanged(bool underPressure);
+
+private slots:
+    void triggered(int fd);
+    void fileChanged(const QString& path);
+
+private:
+    struct Watch {
+        QString resource;
+        QByteArray kind;
+        double limit;
+        int fd;
+        QTimer *clearTimer;
+        bool active;
+    };
+
+    void pollAverage(int index);
+    void stalled(int index);
+    void setActive(int index, bool active);
+
+    QString dir;
+    QVector<Watch> watches;
+    QFileSystemWatcher *fileWatcher;
+    bool polling;
+    bool underPressure;
+};
+
+#endif // PRESSUREMONITOR_H
@@ -5,8 +5,11 @@
 #include "qtlocalpeer.h"
 #include <QCoreApplication>
 #include <QDataStream>
+#include <QElapsedTimer>
 #include <QRegularExpression>
 #include <QTime>
+#include <QTimer>
+#include <QtEndian>
 
 #if defined(Q_OS_WIN)
 #include <QLibrary>
@@ -15,7 +18,14 @@ typedef BOOL(WINAPI*PProcessIdToSessionId)(DWORD,DWORD*);
 static PProcessIdToSessionId pProcessIdToSessionId = 0;
 #endif
 #if defined(Q_OS_UNIX)
+#include <errno.h>
+#include <fcntl.h>
+#include <stddef.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/time.h>
 #include <sys/types.h>
+#include <sys/un.h>
 #include <time.h>
 #include <unistd.h>
 #endif
@@ -30,9 +40,16 @@ namespace QtLP_Private {
 }
 
 const char* QtLocalPeer::ack = "ack";
+const char* QtLocalPeer::nak = "nak";
+
+// A client gets this long to send its message and read the ack
+static const int clientTimeout = 5000;
+static const quint32 maxMessageSize = 1024 * 1024;
+// CBOR self-describe tag (55799) opening every control request
+static const char controlSignature[] = "\xd9\xd9\xf7";
 
 QtLocalPeer::QtLocalPeer(QObject* parent, const QString &appId)
-    : QObject(parent), id(appId)
+    : QObject(parent), id(appId), abstractSocket(false)
 {
     QString prefix = id;
     if (id.isEmpty()) {
@@ -42,13 +59,28 @@ QtLocalPeer::QtLocalPeer(QObject* parent, const QString &appId)
 #endif
         prefix = id.section(QLatin1Char('/'), -1);
     }
+    socketName = makeSocketName(id, prefix);
+
+    server = new QLocalServer(this);
+    QString lockName = QDir(QDir::tempPath()).absolutePath()
+                       + QLatin1Char('/') + socketName
+                       + QLatin1String("-lockfile");
+    lockFile.setFileName(lockName);
+#if defined(Q_OS_LINUX)
+    abstractSocket = qEnvironmentVariableIsEmpty("QTLOCALPEER_NO_ABSTRACT");
+#endif
+}
+
+
+QString QtLocalPeer::makeSocketName(const QString &id, QString prefix)
+{
     prefix.remove(QRegularExpression("[^a-zA-Z]"));
     prefix.truncate(6);
 
     QByteArray idc = id.toUtf8();
     quint16 idNum = qChecksum(idc.constData(), idc.size());
-    socketName = QLatin1String("qtsingleapp-") + prefix
-                 + QLatin1Char('-') + QString::number(idNum, 16);
+    QString socketName = QLatin1String("qtsingleapp-") + prefix
+                         + QLatin1Char('-') + QString::number(idNum, 16);
 
 #if defined(Q_OS_WIN)
     if (!pProcessIdToSessionId) {
@@ -63,22 +95,90 @@ QtLocalPeer::QtLocalPeer(QObject* parent, const QString &appId)
 #else
     socketName += QLatin1Char('-') + QString::number(::getuid(), 16);
 #endif
+    return socketName;
+}
 
-    server = new QLocalServer(this);
-    QString lockName = QDir(QDir::tempPath()).absolutePath()
-                       + QLatin1Char('/') + socketName
-                       + QLatin1String("-lockfile");
-    lockFile.setFileName(lockName);
-    lockFile.open(QIODevice::ReadWrite);
+#if defined(Q_OS_LINUX)
+// The abstract namespace has no files: nothing to clean up after a crash,
+// the name is released with the last descriptor of the listening socket
+static socklen_t abstractAddress(const QString &name, struct sockaddr_un *addr)
+{
+    QByteArray n = name.toLatin1();
+    memset(addr, 0, sizeof(*addr));
+    addr->sun_family = AF_UNIX;
+    size_t len = qMin(size_t(n.size()), sizeof(addr->sun_path) - 1);
+    memcpy(addr->sun_path + 1, n.constData(), len);
+    return socklen_t(offsetof(struct sockaddr_un, sun_path) + 1 + len);
 }
 
+// Abstract sockets have no permissions: only talk to our own user
+static bool peerIsSameUser(int fd)
+{
+    struct ucred cred;
+    socklen_t len = sizeof(cred);
+    return ::getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &cred, &len) == 0
+            && cred.uid == ::getuid();
+}
+
+static int connectAbstract(const QString &name)
+{
+    int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+        return -1;
+    struct sockaddr_un addr;
+    socklen_t len = abstractAddress(name, &addr);
+    if (::connect(fd, reinterpret_cast<struct sockaddr *>(&addr), len) != 0
+            || !peerIsSameUser(fd)) {
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+#endif
 
 
 bool QtLocalPeer::isClient()
 {
-    if (lockFile.isLocked())
+    if (server->isListening() || lockFile.isLocked())
         return false;
 
+#if defined(Q_OS_LINUX)
+    if (abstractSocket) {
+        // one bind() decides: it fails with EADDRINUSE while an instance runs
+        struct sockaddr_un addr;
+        socklen_t len = abstractAddress(socketName, &addr);
+        int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        int err = errno;
+        if (fd >= 0) {
+            if (::bind(fd, reinterpret_cast<struct sockaddr *>(&addr), len) == 0) {
+                if (::listen(fd, SOMAXCONN) == 0 && server->listen(fd)) {
+                    QObject::connect(server, SIGNAL(newConnection()), SLOT(receiveConnection()));
+                    return false;
+                }
+                qWarning("QtLocalPeer: listen on abstract socket failed, %s", qPrintable(server->errorString()));
+                err = 0;
+            } else {
+                err = errno;
+            }
+            ::close(fd);
+        }
+        if (err == EADDRINUSE) {
+            // not yet listening counts as running; a listener of another
+            // user squatting the name does not
+            int peer = connectAbstract(socketName);
+            if (peer >= 0 || errno == ECONNREFUSED) {
+                if (peer >= 0)
+                    ::close(peer);
+                return true;
+            }
+            qWarning("QtLocalPeer: abstract socket %s held by another user", qPrintable(socketName));
+        }
+        abstractSocket = false;
+    }
+#endif
+
+    if (!lockFile.isOpen())
+        lockFile.open(QIODevice::ReadWrite);
     if (!lockFile.lock(QtLP_Private::QtLockedFile::WriteLock, false))
         return true;
 
@@ -97,20 +197,37 @@ bool QtLocalPeer::isClient()
 }
 
 
-bool QtLocalPeer::sendMessage(const QString &message, int timeout)
+bool QtLocalPeer::sendMessage(const QString &message, int timeout, bool *refused)
 {
+    if (refused)
+        *refused = false;
     if (!isClient())
         return false;
 
     QLocalSocket socket;
     bool connOk = false;
-    for(int i = 0; i < 2; i++) {
-        // Try twice, in case the other instance is just starting up
-        socket.connectToServer(socketName);
-        connOk = socket.waitForConnected(timeout/2);
-        if (connOk || i)
+    // Retry with a short backoff, in case the other instance is just
+    // starting up, spending at most half of the timeout on connecting
+    QElapsedTimer elapsed;
+    elapsed.start();
+    for (int backoff = 1; ; backoff = qMin(backoff * 2, 64)) {
+#if defined(Q_OS_LINUX)
+        if (abstractSocket) {
+            int fd = connectAbstract(socketName);
+            connOk = fd >= 0 && socket.setSocketDescriptor(fd);
+            if (fd >= 0 && !connOk)
+                ::close(fd);
+        } else
+#endif
+        {
+            socket.connectToServer(socketName);
+            connOk = socket.waitForConnected(qMax(timeout/2 - int(elapsed.elapsed()), 1));
+        }
+        if (connOk)
+            break;
+        int ms = qMin(backoff, timeout/2 - int(elapsed.elapsed()));
+        if (ms <= 0)
             break;
-        int ms = 250;
 #if defined(Q_OS_WIN)
         Sleep(DWORD(ms));
 #else
@@ -127,51 +244,249 @@ bool QtLocalPeer::sendMessage(const QString &message, int timeout)
     bool res = socket.waitForBytesWritten(timeout);
     if (res) {
         res &= socket.waitForReadyRead(timeout);   // wait for ack
-        if (res)
-            res &= (socket.read(qstrlen(ack)) == ack);
+        if (res) {
+            QByteArray reply = socket.read(qstrlen(ack));
+            if (refused)
+                *refused = reply == nak;
+            res &= reply == ack;
+        }
     }
     return res;
 }
 
 
-void QtLocalPeer::receiveConnection()
+#if defined(Q_OS_UNIX)
+static bool writeAllDirect(int fd, const QByteArray &data)
 {
-    QLocalSocket* socket = server->nextPendingConnection();
-    if (!socket)
-        return;
+    const char *p = data.constData();
+    qint64 left = data.size();
+    while (left > 0) {
+        // a peer going away must not kill us with SIGPIPE
+#if defined(MSG_NOSIGNAL)
+        ssize_t n = ::send(fd, p, size_t(left), MSG_NOSIGNAL);
+#else
+        ssize_t n = ::send(fd, p, size_t(left), 0);
+#endif
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return false;
+        p += n;
+        left -= n;
+    }
+    return true;
+}
+
+static bool readAllDirect(int fd, char *buf, size_t size)
+{
+    size_t got = 0;
+    while (got < size) {
+        ssize_t n = ::read(fd, buf + got, size - got);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return false;
+        got += size_t(n);
+    }
+    return true;
+}
+
+static void setTimeouts(int fd, int timeout)
+{
+    struct timeval tv = { timeout / 1000, (timeout % 1000) * 1000 };
+    ::setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+    ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+}
 
-    while (true) {
-        if (socket->state() == QLocalSocket::UnconnectedState) {
-            qWarning("QtLocalPeer: Peer disconnected");
-            delete socket;
-            return;
+static QByteArray frame(const QByteArray &payload)
+{
+    QByteArray packet(int(sizeof(quint32)), '\0');
+    qToBigEndian<quint32>(quint32(payload.size()), packet.data());
+    return packet + payload;
+}
+#endif
+
+// Connects with plain system calls to the instance holding the abstract
+// socket or the lock for appId: usable from main() before any
+// QCoreApplication exists, and it gives up at once when no instance is
+// running instead of retrying.
+// Returns the socket descriptor or -1.
+int QtLocalPeer::connectDirect(const QString &appId, int timeout)
+{
+#if defined(Q_OS_UNIX)
+    QString name = makeSocketName(appId, appId);
+#if defined(Q_OS_LINUX)
+    int afd = connectAbstract(name);
+    if (afd >= 0) {
+        setTimeouts(afd, timeout);
+        return afd;
+    }
+#endif
+    QString tmp = QDir::cleanPath(QDir::tempPath()) + QLatin1Char('/');
+
+    int lockFd = ::open(QFile::encodeName(tmp + name + QLatin1String("-lockfile")).constData(), O_RDONLY);
+    if (lockFd < 0)
+        return -1;
+    struct flock fl;
+    memset(&fl, 0, sizeof(fl));
+    fl.l_whence = SEEK_SET;
+    fl.l_type = F_WRLCK;
+    int r = ::fcntl(lockFd, F_GETLK, &fl);
+    ::close(lockFd);
+    if (r != 0 || fl.l_type == F_UNLCK)
+        return -1;
+
+    QByteArray path = QFile::encodeName(tmp + name);
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    if (size_t(path.size()) >= sizeof(addr.sun_path))
+        return -1;
+    addr.sun_family = AF_UNIX;
+    memcpy(addr.sun_path, path.constData(), size_t(path.size()));
+
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0)
+        return -1;
+    setTimeouts(fd, timeout);
+    if (::connect(fd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) != 0) {
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+#else
+    Q_UNUSED(appId);
+    Q_UNUSED(timeout);
+    return -1;
+#endif
+}
+
+// Same exchange as sendMessage(), through connectDirect()
+bool QtLocalPeer::sendMessageDirect(const QString &appId, const QString &message, int timeout,
+                                    bool *refused)
+{
+    if (refused)
+        *refused = false;
+#if defined(Q_OS_UNIX)
+    int fd = connectDirect(appId, timeout);
+    if (fd < 0)
+        return false;
+    char reply[3];
+    bool res = writeAllDirect(fd, frame(message.toUtf8()))
+            && readAllDirect(fd, reply, qstrlen(ack));
+    if (res && refused)
+        *refused = memcmp(reply, nak, qstrlen(nak)) == 0;
+    res = res && memcmp(reply, ack, qstrlen(ack)) == 0;
+    ::close(fd);
+    return res;
+#else
+    Q_UNUSED(appId);
+    Q_UNUSED(message);
+    Q_UNUSED(timeout);
+    return false;
+#endif
+}
+
+// Sends one control request (a payload starting with the CBOR
+// self-describe tag) and returns the first reply frame, or a null
+// QByteArray when the instance cannot be reached.
+QByteArray QtLocalPeer::requestDirect(const QString &appId, const QByteArray &request, int timeout)
+{
+#if defined(Q_OS_UNIX)
+    int fd = connectDirect(appId, timeout);
+    if (fd < 0)
+        return QByteArray();
+    QByteArray reply;
+    uchar header[sizeof(quint32)];
+    if (writeAllDirect(fd, frame(request))
+            && readAllDirect(fd, reinterpret_cast<char *>(header), sizeof(header))) {
+        quint32 size = qFromBigEndian<quint32>(header);
+        if (size <= maxMessageSize) {
+            reply.resize(int(size));
+            if (!readAllDirect(fd, reply.data(), size))
+                reply = QByteArray();
         }
-        if (socket->bytesAvailable() >= qint64(sizeof(quint32)))
-            break;
-        socket->waitForReadyRead();
-    }
-
-    QDataStream ds(socket);
-    QByteArray uMsg;
-    quint32 remaining;
-    ds >> remaining;
-    uMsg.resize(remaining);
-    int got = 0;
-    char* uMsgBuf = uMsg.data();
-    do {
-        got = ds.readRawData(uMsgBuf, remaining);
-        remaining -= got;
-        uMsgBuf += got;
-    } while (remaining && got >= 0 && socket->waitForReadyRead(2000));
-    if (got < 0) {
-        qWarning("QtLocalPeer: Message reception failed %s", socket->errorString().toLatin1().constData());
-        delete socket;
+    }
+    ::close(fd);
+    return reply;
+#else
+    Q_UNUSED(appId);
+    Q_UNUSED(request);
+    Q_UNUSED(timeout);
+    return QByteArray();
+#endif
+}
+
+
+void QtLocalPeer::receiveConnection()
+{
+    // Event driven: a slow or stuck client never blocks the event loop and
+    // any number of clients can be served at the same time
+    while (QLocalSocket* socket = server->nextPendingConnection()) {
+#if defined(Q_OS_LINUX)
+        if (!peerIsSameUser(int(socket->socketDescriptor()))) {
+            qWarning("QtLocalPeer: Connection from another user refused");
+            socket->abort();
+            socket->deleteLater();
+            continue;
+        }
+#endif
+        pending.insert(socket, QByteArray());
+        connect(socket, &QLocalSocket::readyRead, this, [this, socket]() { readMessage(socket); });
+        connect(socket, &QLocalSocket::disconnected, this, [this, socket]() { dropConnection(socket); });
+        QTimer* timer = new QTimer(socket);
+        timer->setSingleShot(true);
+        connect(timer, &QTimer::timeout, this, [this, socket]() {
+            if (pending.contains(socket))
+                qWarning("QtLocalPeer: Peer timed out");
+            dropConnection(socket);
+        });
+        timer->start(clientTimeout);
+        readMessage(socket);
+    }
+}
+
+void QtLocalPeer::readMessage(QLocalSocket *socket)
+{
+    auto it = pending.find(socket);
+    if (it == pending.end())
+        return;
+    it->append(socket->readAll());
+    // QDataStream::writeBytes() framing: big endian quint32 length, then data
+    if (it->size() < int(sizeof(quint32)))
+        return;
+    quint32 size = qFromBigEndian<quint32>(it->constData());
+    if (size > maxMessageSize) {
+        qWarning("QtLocalPeer: Message too large (%u bytes)", size);
+        dropConnection(socket);
+        return;
+    }
+    if (quint32(it->size()) - sizeof(quint32) < size)
+        return;
+    if (it->mid(sizeof(quint32), 3) == QByteArray(controlSignature, 3)) {
+        // a control connection: hand the socket and what it sent so far over
+        QByteArray received = *it;
+        pending.erase(it);
+        socket->disconnect(this);
+        qDeleteAll(socket->findChildren<QTimer*>(QString(), Qt::FindDirectChildrenOnly));
+        socket->setParent(0);
+        emit controlConnection(socket, received);
+        return;
+    }
+    QString message(QString::fromUtf8(it->constData() + sizeof(quint32), int(size)));
+    pending.erase(it);
+    // the client closes the connection once it has read the ack
+    if (refusedMessages.contains(message)) {
+        socket->write(nak, qstrlen(nak));
         return;
     }
-    QString message(QString::fromUtf8(uMsg));
     socket->write(ack, qstrlen(ack));
-    socket->waitForBytesWritten(1000);
-    socket->waitForDisconnected(1000); // make sure client reads ack
-    delete socket;
     emit messageReceived(message); //### (might take a long time to return)
 }
+
+void QtLocalPeer::dropConnection(QLocalSocket *socket)
+{
+    pending.remove(socket);
+    socket->disconnect(this);
+    socket->abort();
+    socket->deleteLater();
+}
@@ -7,6 +7,8 @@
 #include <QLocalServer>
 #include <QLocalSocket>
 #include <QDir>
+#include <QHash>
+#include <QSet>
 
 #include "qtlockedfile.h"
 
@@ -17,12 +19,24 @@ class QtLocalPeer : public QObject
 public:
     QtLocalPeer(QObject *parent = 0, const QString &appId = QString());
     bool isClient();
-    bool sendMessage(const QString &message, int timeout);
+    // refused is set when the instance answered that it does not take
+    // this message
+    bool sendMessage(const QString &message, int timeout, bool *refused = 0);
+    static bool sendMessageDirect(const QString &appId, const QString &message, int timeout,
+                                  bool *refused = 0);
+    // Answers message with a refusal instead of emitting messageReceived()
+    void refuseMessage(const QString &message)
+        { refusedMessages.insert(message); }
+    static QByteArray requestDirect(const QString &appId, const QByteArray &request, int timeout);
+    static int connectDirect(const QString &appId, int timeout);
     QString applicationId() const
         { return id; }
 
 Q_SIGNALS:
     void messageReceived(const QString &message);
+    // The receiver takes ownership of socket; received holds the frames
+    // read so far, starting with the first one
+    void controlConnection(QLocalSocket *socket, const QByteArray &received);
 
 protected Q_SLOTS:
     void receiveConnection();
@@ -32,9 +46,21 @@ protected:
     QString socketName;
     QLocalServer* server;
     QtLP_Private::QtLockedFile lockFile;
+    // Linux: single instance through an abstract namespace socket instead
+    // of the lock file (QTLOCALPEER_NO_ABSTRACT=1 forces the lock file)
+    bool abstractSocket;
 
 private:
+    static QString makeSocketName(const QString &id, QString prefix);
+    void readMessage(QLocalSocket *socket);
+    void dropConnection(QLocalSocket *socket);
+
+    // partial message of each connected client
+    QHash<QLocalSocket*, QByteArray> pending;
+    QSet<QString> refusedMessages;
+
     static const char* ack;
+    static const char* nak;
 };
 
 #endif // QTLOCALPEER_H
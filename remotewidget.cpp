@@ -0,0 +1,212 @@
+#include "remotewidget.h"
+#include "controlconnection.h"
+#include "flowlayout.h"
+
+#include <QAction>
+#include <QCborArray>
+#include <QLabel>
+#include <QScrollArea>
+#include <QSplitter>
+#include <QStyle>
+#include <QTextBrowser>
+#include <QTimer>
+#include <QToolButton>
+#include <QVBoxLayout>
+
+#include <QtDebug>
+
+// The headless instance may be restarting
+constexpr auto RECONNECT_MS = 2000;
+// The colors of LauncherItem
+constexpr auto TILE_STYLE = "QToolButton:checked { background-color: rgb(252, 175, 62); }\n"
+                            "QToolButton[ready=\"true\"] { background-color: rgb(138, 226, 52); }\n"
+                            "QToolButton[failed=\"true\"] { background-color: rgb(239, 41, 41); }\n"
+                            "QToolButton[frozen=\"true\"] { background-color: rgb(114, 159, 207); }";
+
+static QIcon loadIcon(const QString& name)
+{
+    QIcon icon = name.startsWith("theme:")? QIcon::fromTheme(name.mid(6)) : QIcon{name};
+    return icon.isNull()? QIcon{":/resources/applauncher.png"} : icon;
+}
+
+static QCborMap controlCommand(const QString& cmd, const QString& name = {})
+{
+    QCborMap c{{"cmd", cmd}};
+    if (!name.isEmpty())
+        c.insert(QString{"name"}, name);
+    return c;
+}
+
+RemoteWidget::RemoteWidget(const QString &appId, QWidget *parent)
+    : QWidget{parent},
+      instanceId{appId},
+      connection{new ControlConnection{this}},
+      statusLabel{new QLabel{this}},
+      tilesWidget{new QWidget},
+      tilesLayout{new FlowLayout{tilesWidget}},
+      logView{new QTextBrowser},
+      reconnectTimer{new QTimer{this}}
+{
+    setWindowTitle(tr("Application Launcher (headless instance)"));
+    setWindowIcon(QIcon{":/resources/applauncher.png"});
+    tilesWidget->setStyleSheet(TILE_STYLE);
+    auto scroll = new QScrollArea;
+    scroll->setWidgetResizable(true);
+    scroll->setWidget(tilesWidget);
+    logView->setFont(QFont{"Monospace, Consolas, Courier"});
+    auto splitter = new QSplitter{Qt::Vertical};
+    splitter->addWidget(scroll);
+    splitter->addWidget(logView);
+    auto layout = new QVBoxLayout{this};
+    layout->addWidget(statusLabel);
+    layout->addWidget(splitter);
+
+    reconnectTimer->setInterval(RECONNECT_MS);
+    connect(reconnectTimer, &QTimer::timeout, this, &RemoteWidget::attach);
+    connect(connection, &ControlConnection::event, this, &RemoteWidget::handleEvent);
+    connect(connection, &ControlConnection::closed, this, &RemoteWidget::detach);
+    attach();
+}
+
+bool RemoteWidget::isAttached() const
+{
+    return connection->isOpen();
+}
+
+void RemoteWidget::attach()
+{
+    if (!connection->open(instanceId))
+        return;
+    reconnectTimer->stop();
+    statusLabel->setText(tr("Entries of the headless instance"));
+    // subscribed before listing: no change falls between the two
+    QCborMap subscribe{{"cmd", "subscribe"}, {"output", true}};
+    connection->request(QCborArray{subscribe, controlCommand("list"), controlCommand("status")},
+                        [this](const QCborArray& results) {
+        setEntries(results.at(1).toMap().value("entries").toArray());
+        const auto configurations = results.at(2).toMap().value("configurations").toArray();
+        for (const auto& c: configurations) {
+            const auto errors = c.toMap().value("errors").toArray();
+            for (const auto& e: errors)
+                appendLog(e.toString() + '\n', Qt::red);
+        }
+    });
+}
+
+void RemoteWidget::detach()
+{
+    statusLabel->setText(tr("The headless instance is not running, waiting for it"));
+    for (auto b: qAsConst(tiles))
+        b->setEnabled(false);
+    reconnectTimer->start();
+}
+
+void RemoteWidget::setEntries(const QCborArray &entries)
+{
+    qDeleteAll(tiles);
+    tiles.clear();
+    for (const auto& e: entries) {
+        auto status = e.toMap();
+        auto name = status.value("name").toString();
+        auto b = new QToolButton{tilesWidget};
+        b->setText(status.value("text").toString(name));
+        b->setIcon(loadIcon(status.value("icon").toString()));
+        b->setIconSize(QSize{64, 64});
+        b->setToolButtonStyle(Qt::ToolButtonTextUnderIcon);
+        b->setCheckable(true);
+        b->setAutoRaise(true);
+        connect(b, &QToolButton::clicked, this, [this, b, name]() {
+            bool stopped = b->property("state").toString() == "stopped" && !b->property("queued").toBool();
+            // the tile shows the state the instance reports, not the click
+            b->setChecked(!stopped);
+            command(stopped? "start" : "stop", name);
+        });
+        const QList<QPair<QString, QString>> actions{
+            {"start", tr("Start")}, {"stop", tr("Stop")}, {"restart", tr("Restart")}};
+        for (const auto& a: actions) {
+            auto action = new QAction{a.second, b};
+            auto cmd = a.first;
+            connect(action, &QAction::triggered, this, [this, cmd, name]() { command(cmd, name); });
+            b->addAction(action);
+        }
+        b->setContextMenuPolicy(Qt::ActionsContextMenu);
+        tilesLayout->addWidget(b);
+        tiles.insert(name, b);
+        updateTile(status);
+    }
+}
+
+void RemoteWidget::updateTile(const QCborMap &status)
+{
+    auto b = tiles.value(status.value("name").toString());
+    if (!b)
+        return;
+    auto state = status.value("state").toString();
+    auto queued = status.value("queued").toBool();
+    b->setProperty("state", state);
+    b->setProperty("queued", queued);
+    b->setProperty("ready", status.value("ready").toBool());
+    b->setProperty("failed", status.value("failed").toBool());
+    b->setProperty("frozen", status.value("frozen").toBool());
+    b->setChecked(state != "stopped");
+    b->setEnabled(status.value("available").toBool() || state != "stopped");
+    if (queued)
+        b->setToolTip(tr("queued"));
+    else if (state == "stopped")
+        b->setToolTip(tr("stopped"));
+    else
+        b->setToolTip(tr("%1, pid %2").arg(state).arg(status.value("pid").toInteger()));
+    b->style()->unpolish(b);
+    b->style()->polish(b);
+}
+
+void RemoteWidget::refresh(const QString &name)
+{
+    connection->request(QCborArray{controlCommand("status", name)}, [this](const QCborArray& results) {
+        auto status = results.at(0).toMap();
+        if (status.value("ok").toBool())
+            updateTile(status);
+    });
+}
+
+void RemoteWidget::command(const QString &cmd, const QString &name)
+{
+    connection->request(QCborArray{controlCommand(cmd, name)}, [this, name](const QCborArray& results) {
+        auto result = results.at(0).toMap();
+        if (!result.value("ok").toBool())
+            appendLog(tr("%1: %2\n").arg(name, result.value("error").toString()), Qt::red);
+        refresh(name);
+    });
+}
+
+void RemoteWidget::handleEvent(const QCborMap &event)
+{
+    auto type = event.value("event").toString();
+    auto name = event.value("name").toString();
+    if (type == "output") {
+        bool isError = event.value("stream").toString() == "stderr";
+        appendLog(event.value("data").toString(), isError? Qt::red : palette().text().color());
+    } else if (type == "dropped") {
+        appendLog(tr("%1 events lost so far\n").arg(event.value("count").toInteger()), Qt::darkYellow);
+    } else {
+        if (type == "exited")
+            appendLog(tr("%1 exited with code %2%3\n")
+                      .arg(name)
+                      .arg(event.value("exitCode").toInteger())
+                      .arg(event.value("crashed").toBool()? tr(" (crashed)") : QString{}),
+                      Qt::darkGray);
+        refresh(name);
+    }
+}
+
+void RemoteWidget::appendLog(const QString &text, const QColor &color)
+{
+    auto c = logView->textCursor();
+    c.movePosition(QTextCursor::End);
+    QTextCharFormat fmt;
+    fmt.setForeground(color);
+    c.setCharFormat(fmt);
+    c.insertText(text);
+    logView->setTextCursor(c);
+    logView->ensureCursorVisible();
+}
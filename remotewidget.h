@@ -0,0 +1,48 @@
+#ifndef REMOTEWIDGET_H
+#define REMOTEWIDGET_H
+
+#include <QWidget>
+#include <QCborMap>
+#include <QHash>
+
+class QLabel;
+class QTextBrowser;
+class QTimer;
+class QToolButton;
+class ControlConnection;
+class FlowLayout;
+
+// Window of a launcher whose configurations run in a headless instance
+// (--daemon): it shows and drives that instance's entries through the
+// control protocol, and follows their output through a subscription.
+// The window owns no process: closing it leaves the entries running.
+class RemoteWidget : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit RemoteWidget(const QString& appId, QWidget *parent = nullptr);
+
+    bool isAttached() const;
+
+private:
+    void attach();
+    void detach();
+    void setEntries(const QCborArray& entries);
+    void updateTile(const QCborMap& status);
+    void refresh(const QString& name);
+    void command(const QString& cmd, const QString& name);
+    void handleEvent(const QCborMap& event);
+    void appendLog(const QString& text, const QColor& color);
+
+    QString instanceId;
+    ControlConnection *connection;
+    QLabel *statusLabel;
+    QWidget *tilesWidget;
+    FlowLayout *tilesLayout;
+    QTextBrowser *logView;
+    QTimer *reconnectTimer;
+    QHash<QString, QToolButton *> tiles;
+};
+
+#endif // REMOTEWIDGET_H
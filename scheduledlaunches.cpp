@@ -0,0 +1,137 @@
+#include "scheduledlaunches.h"
+#include "launchentry.h"
+
+#include <QDateTime>
+#include <QJsonObject>
+#include <QTimer>
+#include <QtDebug>
+
+// A run noticed this late (in seconds) was missed rather than delayed
+constexpr auto MISSED_AFTER = 60;
+
+static qint64 currentSecs()
+{
+    return QDateTime::currentSecsSinceEpoch();
+}
+
+ScheduledLaunches::ScheduledLaunches(QObject *parent)
+    : QObject{parent},
+      wheel{currentSecs()},
+      ticker{new QTimer{this}}
+{
+    ticker->setInterval(1000);
+    connect(ticker, &QTimer::timeout, this, &ScheduledLaunches::tick);
+}
+
+ScheduledLaunches::Overlap ScheduledLaunches::overlapFromName(const QString &name)
+{
+    if (name == "queue")
+        return Queue;
+    if (name == "kill")
+        return Kill;
+    return Skip;
+}
+
+bool ScheduledLaunches::addJob(LaunchEntry *item, const QJsonObject &schedule)
+{
+    Job job{item, 0, {}, overlapFromName(schedule.value("overlap").toString()),
+            schedule.value("catchUp").toBool(true), false, 0};
+    if (schedule.contains("cron")) {
+        bool ok = false;
+        job.cron = CronSchedule::parse(schedule.value("cron").toString(), &ok);
+        if (!ok) {
+            qWarning() << "invalid cron schedule" << schedule.value("cron").toString();
+            return false;
+        }
+    } else {
+        job.interval = qint64(schedule.value("interval").toDouble());
+        if (job.interval <= 0) {
+            qWarning() << "schedule without a valid interval or cron";
+            return false;
+        }
+    }
+    auto id = jobs.size();
+    jobs.append(job);
+    connect(item, &LaunchEntry::stateChange, this, [this, id]() { itemStateChanged(id); });
+    connect(item, &QObject::destroyed, this, [this, id]() {
+        wheel.cancel(quint64(id));
+        jobs[id].item = nullptr;
+    });
+    arm(id, currentSecs());
+    if (!ticker->isActive())
+        ticker->start();
+    return true;
+}
+
+void ScheduledLaunches::arm(int id, qint64 now)
+{
+    auto& job = jobs[id];
+    if (job.interval > 0) {
+        job.due = now + job.interval;
+    } else {
+        auto next = job.cron.next(QDateTime::fromSecsSinceEpoch(now));
+        if (!next.isValid()) {
+            qWarning() << "cron schedule never matches again, dropped";
+            return;
+        }
+        job.due = next.toSecsSinceEpoch();
+    }
+    wheel.schedule(quint64(id), job.due);
+}
+
+void ScheduledLaunches::tick()
+{
+    auto now = currentSecs();
+    if (now < wheel.now()) {
+        // the clock went backwards: lay everything out again from now
+        wheel = TimerWheel{now};
+        for (int id = 0; id < jobs.size(); id++)
+            if (jobs.at(id).item)
+                arm(id, now);
+        return;
+    }
+    const auto expired = wheel.advance(now);
+    for (auto id: expired) {
+        auto& job = jobs[int(id)];
+        if (!job.item)
+            continue;
+        // every run missed in the meantime collapses into this one
+        if (job.catchUp || now - job.due < MISSED_AFTER)
+            run(job);
+        else
+            qDebug() << "scheduled run missed" << QDateTime::fromSecsSinceEpoch(job.due);
+        arm(int(id), now);
+    }
+}
+
+void ScheduledLaunches::run(Job &job)
+{
+    auto item = job.item;
+    if (item->isQueued())
+        return;
+    if (item->state() == QProcess::NotRunning) {
+        item->start();
+        return;
+    }
+    switch (job.overlap) {
+    case Skip:
+        qDebug() << "scheduled run skipped, still running";
+        break;
+    case Queue:
+        job.pending = true;
+        break;
+    case Kill:
+        job.pending = true;
+        item->stop();
+        break;
+    }
+}
+
+void ScheduledLaunches::itemStateChanged(int id)
+{
+    auto& job = jobs[id];
+    if (job.item && job.pending && job.item->state() == QProcess::NotRunning) {
+        job.pending = false;
+        job.item->start();
+    }
+}
@@ -0,0 +1,54 @@
+#ifndef SCHEDULEDLAUNCHES_H
+#define SCHEDULEDLAUNCHES_H
+
+#include <QObject>
+#include <QVector>
+
+#include "cronschedule.h"
+#include "timerwheel.h"
+
+class QJsonObject;
+class QTimer;
+class LaunchEntry;
+
+// Starts entries periodically or on a cron schedule. All the jobs share a
+// single timer wheel stepped once per second on wall clock time, so the
+// cost of a tick does not depend on the number of jobs and runs missed
+// while the machine was suspended are noticed as soon as it resumes.
+class ScheduledLaunches : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Overlap {Skip, Queue, Kill};
+
+    explicit ScheduledLaunches(QObject *parent = nullptr);
+
+    bool addJob(LaunchEntry *item, const QJsonObject& schedule);
+
+    static Overlap overlapFromName(const QString& name);
+
+private slots:
+    void tick();
+
+private:
+    struct Job {
+        LaunchEntry *item;
+        qint64 interval;
+        CronSchedule cron;
+        Overlap overlap;
+        bool catchUp;
+        bool pending;
+        qint64 due;
+    };
+
+    void arm(int id, qint64 now);
+    void run(Job& job);
+    void itemStateChanged(int id);
+
+    QVector<Job> jobs;
+    TimerWheel wheel;
+    QTimer *ticker;
+};
+
+#endif // SCHEDULEDLAUNCHES_H
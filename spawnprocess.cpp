@@ -0,0 +1,360 @@
+#include "spawnprocess.h"
+
+#include <QFile>
+#include <QSocketNotifier>
+#include <QStandardPaths>
+#include <QTimer>
+#include <QVector>
+
+#include <QtDebug>
+
+#include <cerrno>
+#include <csignal>
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/syscall.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 29))
+#define HAVE_SPAWN_ADDCHDIR
+#endif
+
+extern char **environ;
+
+constexpr auto CHILD_POLL_INTERVAL = 50;
+
+static int openPidFd(qint64 pid)
+{
+#if defined(Q_OS_LINUX) && defined(SYS_pidfd_open)
+    return int(::syscall(SYS_pidfd_open, pid_t(pid), 0));
+#else
+    Q_UNUSED(pid)
+    return -1;
+#endif
+}
+
+static bool makePipe(int fds[2])
+{
+    if (::pipe(fds) != 0)
+        return false;
+    ::fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+    ::fcntl(fds[1], F_SETFD, FD_CLOEXEC);
+    return true;
+}
+
+static void closeFd(int& fd)
+{
+    if (fd != -1)
+        ::close(fd);
+    fd = -1;
+}
+
+static QVector<char *> toCharArray(QList<QByteArray>& storage)
+{
+    QVector<char *> v;
+    v.reserve(storage.size() + 1);
+    for (auto& s: storage)
+        v.append(s.data());
+    v.append(nullptr);
+    return v;
+}
+
+static int spawnChild(pid_t *child,
+                      const QByteArray& path,
+                      const QByteArray& workdir,
+                      char *const argv[],
+                      char *const envp[],
+                      const int in[2], const int out[2], const int err[2])
+{
+#ifdef HAVE_SPAWN_ADDCHDIR
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_adddup2(&actions, in[0], STDIN_FILENO);
+    posix_spawn_file_actions_adddup2(&actions, out[1], STDOUT_FILENO);
+    posix_spawn_file_actions_adddup2(&actions, err[1], STDERR_FILENO);
+    if (!workdir.isEmpty())
+        posix_spawn_file_actions_addchdir_np(&actions, workdir.constData());
+
+    posix_spawnattr_t attr;
+    posix_spawnattr_init(&attr);
+    sigset_t mask;
+    sigemptyset(&mask);
+    posix_spawnattr_setsigmask(&attr, &mask);
+    sigset_t defaults;
+    sigemptyset(&defaults);
+    sigaddset(&defaults, SIGPIPE);
+    posix_spawnattr_setsigdefault(&attr, &defaults);
+    // own process group, so the whole tree can be frozen at once
+    posix_spawnattr_setpgroup(&attr, 0);
+    posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSIGDEF | POSIX_SPAWN_SETPGROUP);
+
+    int r = ::posix_spawn(child, path.constData(), &actions, &attr, argv, envp);
+
+    posix_spawnattr_destroy(&attr);
+    posix_spawn_file_actions_destroy(&actions);
+    return r;
+#else
+    // No posix_spawn_file_actions_addchdir_np(): do the same thing by hand.
+    // The vfork child shares our memory, so it can hand errno back directly.
+    volatile int childErrno = 0;
+    pid_t p = ::vfork();
+    if (p == 0) {
+        ::dup2(in[0], STDIN_FILENO);
+        ::dup2(out[1], STDOUT_FILENO);
+        ::dup2(err[1], STDERR_FILENO);
+        sigset_t mask;
+        sigemptyset(&mask);
+        ::sigprocmask(SIG_SETMASK, &mask, nullptr);
+        ::signal(SIGPIPE, SIG_DFL);
+        ::setpgid(0, 0);
+        if (workdir.isEmpty() || ::chdir(workdir.constData()) == 0)
+            ::execve(path.constData(), argv, envp);
+        childErrno = errno;
+        ::_exit(127);
+    }
+    if (p < 0)
+        return errno;
+    if (childErrno != 0) {
+        ::waitpid(p, nullptr, 0);
+        return childErrno;
+    }
+    *child = p;
+    return 0;
+#endif
+}
+
+SpawnProcess::SpawnProcess(QObject *parent)
+    : LaunchProcess{parent},
+      currentState{QProcess::NotRunning},
+      pid{0},
+      stdinFd{-1},
+      stdoutFd{-1},
+      stderrFd{-1},
+      childFd{-1},
+      stdoutNotifier{nullptr},
+      stderrNotifier{nullptr},
+      childNotifier{nullptr},
+      childPoll{new QTimer{this}}
+{
+    childPoll->setInterval(CHILD_POLL_INTERVAL);
+    connect(childPoll, &QTimer::timeout, this, &SpawnProcess::checkChild);
+}
+
+SpawnProcess::~SpawnProcess()
+{
+    if (pid > 0) {
+        ::kill(pid_t(pid), SIGKILL);
+        ::waitpid(pid_t(pid), nullptr, 0);
+    }
+    closeChannels();
+}
+
+void SpawnProcess::setWorkingDirectory(const QString &dir)
+{
+    workingDirectory = dir;
+}
+
+void SpawnProcess::setProcessEnvironment(const QProcessEnvironment &env)
+{
+    environment = env;
+}
+
+QProcess::ProcessState SpawnProcess::state() const
+{
+    return currentState;
+}
+
+qint64 SpawnProcess::processId() const
+{
+    return pid;
+}
+
+QByteArray SpawnProcess::readAllStandardOutput()
+{
+    QByteArray r;
+    r.swap(stdoutBuffer);
+    return r;
+}
+
+QByteArray SpawnProcess::readAllStandardError()
+{
+    QByteArray r;
+    r.swap(stderrBuffer);
+    return r;
+}
+
+void SpawnProcess::start(const QString &program, const QStringList &arguments)
+{
+    if (currentState != QProcess::NotRunning) {
+        qWarning("SpawnProcess::start: process is already running");
+        return;
+    }
+    beginSpawnMeasure();
+    setState(QProcess::Starting);
+
+    // bare names are searched in the PATH the child gets, which the
+    // entry environment may set, and only otherwise in our own
+    auto exe = program;
+    if (!exe.contains('/')) {
+        QStringList paths;
+        if (environment.contains("PATH"))
+            paths = environment.value("PATH").split(':', Qt::SkipEmptyParts);
+        auto found = QStandardPaths::findExecutable(exe, paths);
+        if (!found.isEmpty())
+            exe = found;
+    }
+
+    QList<QByteArray> argStorage{ QFile::encodeName(exe) };
+    for (const auto& a: arguments)
+        argStorage.append(a.toLocal8Bit());
+    auto argv = toCharArray(argStorage);
+
+    QList<QByteArray> envStorage;
+    for (const auto& e: environment.toStringList())
+        envStorage.append(e.toLocal8Bit());
+    auto envp = toCharArray(envStorage);
+
+    int in[2] = { -1, -1 };
+    int out[2] = { -1, -1 };
+    int err[2] = { -1, -1 };
+    int r = 0;
+    if (!makePipe(in) || !makePipe(out) || !makePipe(err))
+        r = errno;
+
+    pid_t child = 0;
+    if (r == 0)
+        r = spawnChild(&child, QFile::encodeName(exe), QFile::encodeName(workingDirectory),
+                       argv.data(), environment.isEmpty()? environ : envp.data(),
+                       in, out, err);
+    if (r == 0)
+        markExec();
+    closeFd(in[0]);
+    closeFd(out[1]);
+    closeFd(err[1]);
+
+    if (r != 0) {
+        closeFd(in[1]);
+        closeFd(out[0]);
+        closeFd(err[0]);
+        qDebug() << "spawn" << program << "failed:" << qt_error_string(r);
+        emit errorOccurred(QProcess::FailedToStart);
+        setState(QProcess::NotRunning);
+        return;
+    }
+
+    pid = child;
+    stdinFd = in[1];
+    stdoutFd = out[0];
+    stderrFd = err[0];
+    ::fcntl(stdoutFd, F_SETFL, ::fcntl(stdoutFd, F_GETFL) | O_NONBLOCK);
+    ::fcntl(stderrFd, F_SETFL, ::fcntl(stderrFd, F_GETFL) | O_NONBLOCK);
+    stdoutNotifier = new QSocketNotifier{stdoutFd, QSocketNotifier::Read, this};
+    connect(stdoutNotifier, SIGNAL(activated(int)), SLOT(readStandardOutput()));
+    stderrNotifier = new QSocketNotifier{stderrFd, QSocketNotifier::Read, this};
+    connect(stderrNotifier, SIGNAL(activated(int)), SLOT(readStandardError()));
+    watchChild();
+
+    endSpawnMeasure("spawn");
+    setState(QProcess::Running);
+    emit started();
+}
+
+void SpawnProcess::terminate()
+{
+    if (pid > 0)
+        ::kill(pid_t(pid), SIGTERM);
+}
+
+void SpawnProcess::setState(QProcess::ProcessState newState)
+{
+    if (currentState == newState)
+        return;
+    currentState = newState;
+    emit stateChanged(newState);
+}
+
+void SpawnProcess::watchChild()
+{
+    childFd = openPidFd(pid);
+    if (childFd != -1) {
+        childNotifier = new QSocketNotifier{childFd, QSocketNotifier::Read, this};
+        connect(childNotifier, SIGNAL(activated(int)), SLOT(checkChild()));
+    } else {
+        childPoll->start();
+    }
+}
+
+void SpawnProcess::readStandardOutput()
+{
+    readChannel(stdoutNotifier, stdoutBuffer, false);
+}
+
+void SpawnProcess::readStandardError()
+{
+    readChannel(stderrNotifier, stderrBuffer, true);
+}
+
+void SpawnProcess::readChannel(QSocketNotifier *notifier, QByteArray &buffer, bool isError)
+{
+    if (!notifier)
+        return;
+    char chunk[4096];
+    qint64 total = 0;
+    ssize_t n;
+    while ((n = ::read(int(notifier->socket()), chunk, sizeof(chunk))) > 0) {
+        buffer.append(chunk, int(n));
+        total += n;
+    }
+    if (n == 0)
+        notifier->setEnabled(false);
+    if (total == 0)
+        return;
+    if (isError)
+        emit readyReadStandardError();
+    else
+        emit readyReadStandardOutput();
+}
+
+void SpawnProcess::checkChild()
+{
+    int status = 0;
+    auto r = ::waitpid(pid_t(pid), &status, WNOHANG);
+    if (r == 0 || (r < 0 && errno == EINTR))
+        return;
+
+    readChannel(stdoutNotifier, stdoutBuffer, false);
+    readChannel(stderrNotifier, stderrBuffer, true);
+    closeChannels();
+    pid = 0;
+
+    auto exitStatus = QProcess::NormalExit;
+    int exitCode = -1;
+    if (r > 0 && WIFEXITED(status)) {
+        exitCode = WEXITSTATUS(status);
+    } else {
+        exitStatus = QProcess::CrashExit;
+        if (r > 0 && WIFSIGNALED(status))
+            exitCode = WTERMSIG(status);
+        emit errorOccurred(QProcess::Crashed);
+    }
+    setState(QProcess::NotRunning);
+    emit finished(exitCode, exitStatus);
+}
+
+void SpawnProcess::closeChannels()
+{
+    childPoll->stop();
+    for (auto n: { stdoutNotifier, stderrNotifier, childNotifier }) {
+        if (n) {
+            n->setEnabled(false);
+            n->deleteLater();
+        }
+    }
+    stdoutNotifier = stderrNotifier = childNotifier = nullptr;
+    closeFd(stdinFd);
+    closeFd(stdoutFd);
+    closeFd(stderrFd);
+    closeFd(childFd);
+}
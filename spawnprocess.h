@@ -0,0 +1,62 @@
+#ifndef SPAWNPROCESS_H
+#define SPAWNPROCESS_H
+
+#include "launchprocess.h"
+
+#include <QProcessEnvironment>
+
+class QSocketNotifier;
+class QTimer;
+
+// posix_spawn() based backend: the child is created with vfork semantics
+// (no copy of the launcher page tables) but keeps the QProcess pipes,
+// environment and working directory behaviour.
+class SpawnProcess : public LaunchProcess
+{
+    Q_OBJECT
+
+public:
+    explicit SpawnProcess(QObject *parent = nullptr);
+    ~SpawnProcess() override;
+
+    void setWorkingDirectory(const QString& dir) override;
+    void setProcessEnvironment(const QProcessEnvironment& env) override;
+
+    QProcess::ProcessState state() const override;
+    qint64 processId() const override;
+
+    QByteArray readAllStandardOutput() override;
+    QByteArray readAllStandardError() override;
+
+public slots:
+    void start(const QString& program, const QStringList& arguments) override;
+    void terminate() override;
+
+private slots:
+    void readStandardOutput();
+    void readStandardError();
+    void checkChild();
+
+private:
+    void setState(QProcess::ProcessState newState);
+    void watchChild();
+    void readChannel(QSocketNotifier *notifier, QByteArray& buffer, bool isError);
+    void closeChannels();
+
+    QString workingDirectory;
+    QProcessEnvironment environment;
+    QProcess::ProcessState currentState;
+    qint64 pid;
+    int stdinFd;
+    int stdoutFd;
+    int stderrFd;
+    int childFd;
+    QSocketNotifier *stdoutNotifier;
+    QSocketNotifier *stderrNotifier;
+    QSocketNotifier *childNotifier;
+    QTimer *childPoll;
+    QByteArray stdoutBuffer;
+    QByteArray stderrBuffer;
+};
+
+#endif // SPAWNPROCESS_H
@@ -0,0 +1,7 @@
+QT += testlib widgets
+CONFIG += testcase c++17
+TARGET = tst_flowlayout
+
+INCLUDEPATH += ../..
+SOURCES += tst_flowlayout.cpp ../../flowlayout.cpp
+HEADERS += ../../flowlayout.h
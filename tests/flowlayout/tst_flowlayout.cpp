@@ -0,0 +1,175 @@
+#include "flowlayout.h"
+
+#include <QElapsedTimer>
+#include <QSpacerItem>
+#include <QtTest>
+
+constexpr auto ITEMS = 10000;
+// A resize pass over every item, well within a frame in a release build
+// and still a few frames in a debug one
+constexpr auto PASS_BUDGET_MS = 50;
+
+// Counts the size hints asked and the geometries set by the layout
+class CountingItem : public QSpacerItem
+{
+public:
+    CountingItem(int width, int height, int *hints, int *geometries)
+        : QSpacerItem{width, height, QSizePolicy::Fixed, QSizePolicy::Fixed},
+          hints{hints},
+          geometries{geometries}
+    {
+    }
+
+    QSize sizeHint() const override
+    {
+        ++*hints;
+        return QSpacerItem::sizeHint();
+    }
+
+    void setGeometry(const QRect &r) override
+    {
+        ++*geometries;
+        QSpacerItem::setGeometry(r);
+    }
+
+private:
+    int *hints;
+    int *geometries;
+};
+
+class TestFlowLayout : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+    void resumesAtChangedItem();
+    void hiddenItemMovesFollowers();
+    void marginsMoveEverything();
+    void resizesWithCachedHints();
+    void resizeBenchmark();
+
+private:
+    FlowLayout *fill(int *hints, int *geometries) const;
+    static void compareWithFreshLayout(FlowLayout *layout, const QRect &rect);
+
+    FlowLayout *layout = nullptr;
+    int hints = 0;
+    int geometries = 0;
+};
+
+static QSize itemSize(int i)
+{
+    return {20 + (i % 7) * 5, 30 + (i % 3) * 4};
+}
+
+FlowLayout *TestFlowLayout::fill(int *hintCount, int *geometryCount) const
+{
+    auto l = new FlowLayout{0, 4, 4};
+    for (int i = 0; i < ITEMS; i++) {
+        auto size = itemSize(i);
+        l->addItem(new CountingItem{size.width(), size.height(), hintCount, geometryCount});
+    }
+    return l;
+}
+
+// The incremental pass must leave every item where a full pass over a
+// new layout puts it
+void TestFlowLayout::compareWithFreshLayout(FlowLayout *l, const QRect &rect)
+{
+    int hintCount = 0;
+    int geometryCount = 0;
+    FlowLayout fresh{0, 4, 4};
+    for (int i = 0; i < l->count(); i++) {
+        auto size = l->itemAt(i)->sizeHint();
+        fresh.addItem(new CountingItem{size.width(), size.height(), &hintCount, &geometryCount});
+    }
+    fresh.setGeometry(rect);
+    for (int i = 0; i < l->count(); i++)
+        QCOMPARE(l->itemAt(i)->geometry(), fresh.itemAt(i)->geometry());
+}
+
+void TestFlowLayout::init()
+{
+    hints = geometries = 0;
+    layout = fill(&hints, &geometries);
+}
+
+void TestFlowLayout::cleanup()
+{
+    delete layout;
+    layout = nullptr;
+}
+
+void TestFlowLayout::resumesAtChangedItem()
+{
+    QRect rect{0, 0, 800, 100000};
+    layout->setGeometry(rect);
+    QCOMPARE(geometries, ITEMS);
+
+    // what a child's updateGeometry() does
+    static_cast<QSpacerItem *>(layout->itemAt(ITEMS - 10))->changeSize(90, 30);
+    layout->invalidate();
+    geometries = 0;
+    layout->setGeometry(rect);
+    QCOMPARE(geometries, 10);
+    compareWithFreshLayout(layout, rect);
+}
+
+void TestFlowLayout::hiddenItemMovesFollowers()
+{
+    QRect rect{0, 0, 800, 100000};
+    layout->setGeometry(rect);
+
+    // a hidden widget has an empty size hint
+    static_cast<QSpacerItem *>(layout->itemAt(ITEMS / 2))->changeSize(0, 0);
+    layout->invalidate();
+    geometries = 0;
+    layout->setGeometry(rect);
+    QCOMPARE(geometries, ITEMS - ITEMS / 2);
+    compareWithFreshLayout(layout, rect);
+}
+
+void TestFlowLayout::marginsMoveEverything()
+{
+    QRect rect{0, 0, 800, 100000};
+    layout->setGeometry(rect);
+
+    layout->setContentsMargins(3, 3, 3, 3);
+    geometries = 0;
+    layout->setGeometry(rect);
+    QCOMPARE(geometries, ITEMS);
+    QCOMPARE(layout->itemAt(0)->geometry().topLeft(), QPoint(3, 3));
+}
+
+void TestFlowLayout::resizesWithCachedHints()
+{
+    layout->setGeometry({0, 0, 800, 100000});
+    hints = 0;
+    QElapsedTimer timer;
+    timer.start();
+    int passes = 0;
+    for (int width = 400; width <= 1600; width += 25, passes++) {
+        auto height = layout->heightForWidth(width);
+        // memoized
+        QCOMPARE(layout->heightForWidth(width), height);
+        layout->setGeometry({0, 0, width, height});
+    }
+    // a resize lays the items out again, it does not ask them anything
+    QCOMPARE(hints, 0);
+    QVERIFY2(timer.elapsed() < passes * PASS_BUDGET_MS,
+             qPrintable(QString{"%1 ms for %2 resizes"}.arg(timer.elapsed()).arg(passes)));
+}
+
+void TestFlowLayout::resizeBenchmark()
+{
+    int width = 400;
+    QBENCHMARK {
+        width = width >= 1600? 400 : width + 25;
+        layout->setGeometry({0, 0, width, layout->heightForWidth(width)});
+    }
+}
+
+QTEST_MAIN(TestFlowLayout)
+#include "tst_flowlayout.moc"
@@ -0,0 +1,9 @@
+QT -= gui
+QT += network testlib
+CONFIG += testcase c++17
+TARGET = tst_localpeer
+
+PEER_SRC = ../../qtsingleapplication/src
+INCLUDEPATH += $$PEER_SRC
+SOURCES += tst_localpeer.cpp $$PEER_SRC/qtlocalpeer.cpp
+HEADERS += $$PEER_SRC/qtlocalpeer.h
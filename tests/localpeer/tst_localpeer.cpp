@@ -0,0 +1,93 @@
+#include <qtlocalpeer.h>
+
+#include <QElapsedTimer>
+#include <QTimer>
+#include <QtTest>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+constexpr auto CLIENTS = 100;
+constexpr auto MESSAGES = 20;
+// Clients that connect, send half a length and then nothing
+constexpr auto STALLED_CLIENTS = 10;
+// Every that many clients sends large messages
+constexpr auto LARGE_EVERY = 10;
+constexpr auto LARGE_SIZE = 512 * 1024;
+constexpr auto SEND_TIMEOUT = 5000;
+constexpr auto HEARTBEAT_MS = 5;
+// Far below the one second waits a blocking peer spent per slow client
+constexpr auto STALL_LIMIT_MS = 200;
+constexpr auto WAIT_LIMIT_MS = 30000;
+
+class TestLocalPeer : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void concurrentClients();
+};
+
+// The server serves every client while the event loop keeps running
+void TestLocalPeer::concurrentClients()
+{
+    auto appId = QString{"tst_localpeer-%1"}.arg(QCoreApplication::applicationPid());
+    QtLocalPeer server{nullptr, appId};
+    QVERIFY(!server.isClient());
+    int received = 0;
+    connect(&server, &QtLocalPeer::messageReceived, this, [&received]() { received++; });
+
+    QTimer heartbeat;
+    QElapsedTimer sinceBeat;
+    qint64 maxStall = 0;
+    heartbeat.setInterval(HEARTBEAT_MS);
+    connect(&heartbeat, &QTimer::timeout, this, [&]() { maxStall = qMax(maxStall, sinceBeat.restart()); });
+    sinceBeat.start();
+    heartbeat.start();
+
+    std::vector<int> stalled;
+    for (int i = 0; i < STALLED_CLIENTS; i++) {
+        int fd = QtLocalPeer::connectDirect(appId, SEND_TIMEOUT);
+        QVERIFY(fd >= 0);
+        QCOMPARE(::write(fd, "\0\0", 2), ssize_t(2));
+        stalled.push_back(fd);
+    }
+
+    std::atomic<int> sent{0};
+    std::vector<std::thread> clients;
+    for (int c = 0; c < CLIENTS; c++) {
+        clients.emplace_back([&sent, appId, c]() {
+            auto size = c % LARGE_EVERY == 0? LARGE_SIZE : 64;
+            auto message = QString{size, QLatin1Char('a' + c % 26)};
+            // half through QLocalSocket, half through plain system calls
+            QtLocalPeer peer{nullptr, appId};
+            for (int m = 0; m < MESSAGES; m++) {
+                bool ok = c % 2? peer.sendMessage(message, SEND_TIMEOUT)
+                               : QtLocalPeer::sendMessageDirect(appId, message, SEND_TIMEOUT);
+                if (ok)
+                    sent++;
+            }
+        });
+    }
+
+    // the clients are joined before any check can return
+    QElapsedTimer waiting;
+    waiting.start();
+    while (received < CLIENTS * MESSAGES && !waiting.hasExpired(WAIT_LIMIT_MS))
+        QTest::qWait(HEARTBEAT_MS);
+    for (auto& t: clients)
+        t.join();
+    for (auto fd: stalled)
+        ::close(fd);
+    heartbeat.stop();
+
+    QCOMPARE(received, CLIENTS * MESSAGES);
+    QCOMPARE(sent.load(), CLIENTS * MESSAGES);
+    QVERIFY2(maxStall < STALL_LIMIT_MS, qPrintable(QString{"event loop stalled for %1 ms"}.arg(maxStall)));
+}
+
+QTEST_GUILESS_MAIN(TestLocalPeer)
+#include "tst_localpeer.moc"
@@ -0,0 +1,7 @@
+# Unit tests, built apart from the application:
+#
+#     qmake tests/tests.pro && make && make check
+
+TEMPLATE = subdirs
+SUBDIRS = flowlayout
+unix: SUBDIRS += localpeer
@@ -0,0 +1,90 @@
+#include "timerwheel.h"
+
+TimerWheel::TimerWheel(qint64 now)
+    : current{now},
+      buckets(SLOTS * LEVELS)
+{
+}
+
+void TimerWheel::schedule(quint64 id, qint64 expires)
+{
+    cancel(id);
+    place(id, expires);
+}
+
+void TimerWheel::cancel(quint64 id)
+{
+    auto it = timers.find(id);
+    if (it == timers.end())
+        return;
+    buckets[it->bucket].remove(id);
+    timers.erase(it);
+}
+
+void TimerWheel::place(quint64 id, qint64 expires)
+{
+    // the bucket of the current tick was already processed: anything due
+    // goes to the next one
+    auto at = qMax(expires, current + 1);
+    auto delta = at - current;
+    int level = 0;
+    while (level < LEVELS - 1 && delta >= (qint64(1) << (BITS * (level + 1))))
+        level++;
+    // timers beyond the last level wait in its furthest bucket and are
+    // placed again when it cascades
+    at = qMin(at, current + ((qint64(SLOTS) - 1) << (BITS * level)));
+    auto slot = int(at >> (BITS * level)) & (SLOTS - 1);
+    auto bucket = level * SLOTS + slot;
+    timers.insert(id, Timer{expires, bucket});
+    buckets[bucket].insert(id);
+}
+
+void TimerWheel::cascade(int level)
+{
+    auto slot = int(current >> (BITS * level)) & (SLOTS - 1);
+    auto ids = buckets[level * SLOTS + slot];
+    buckets[level * SLOTS + slot].clear();
+    for (auto id: qAsConst(ids))
+        place(id, timers.value(id).expires);
+}
+
+QVector<quint64> TimerWheel::advance(qint64 now)
+{
+    QVector<quint64> expired;
+    if (now - current > MAX_STEPS) {
+        // long jump (e.g. resume after suspend): collect what is due and
+        // lay the rest out again around the new time
+        current = now;
+        const auto all = timers;
+        timers.clear();
+        for (auto& b: buckets)
+            b.clear();
+        for (auto it = all.constBegin(); it != all.constEnd(); ++it) {
+            if (it->expires <= now)
+                expired.append(it.key());
+            else
+                place(it.key(), it->expires);
+        }
+        return expired;
+    }
+    while (current < now) {
+        current++;
+        for (int level = 1; level < LEVELS; level++) {
+            if (current & ((qint64(1) << (BITS * level)) - 1))
+                break;
+            cascade(level);
+        }
+        auto& bucket = buckets[int(current) & (SLOTS - 1)];
+        if (bucket.isEmpty())
+            continue;
+        const auto ids = bucket;
+        for (auto id: ids) {
+            if (timers.value(id).expires <= current) {
+                bucket.remove(id);
+                timers.remove(id);
+                expired.append(id);
+            }
+        }
+    }
+    return expired;
+}
@@ -0,0 +1,46 @@
+#ifndef TIMERWHEEL_H
+#define TIMERWHEEL_H
+
+#include <QHash>
+#include <QSet>
+#include <QVector>
+
+// Hierarchical timing wheel: LEVELS wheels of SLOTS buckets, each level
+// ticking SLOTS times slower than the previous one. Scheduling and
+// cancelling are O(1) and a tick only touches one bucket (plus a cascade
+// every SLOTS ticks), whatever the number of pending timers.
+class TimerWheel
+{
+public:
+    explicit TimerWheel(qint64 now = 0);
+
+    void schedule(quint64 id, qint64 expires);
+    void cancel(quint64 id);
+    bool contains(quint64 id) const { return timers.contains(id); }
+
+    // Moves the wheel to now and returns the ids of the expired timers
+    QVector<quint64> advance(qint64 now);
+
+    qint64 now() const { return current; }
+
+private:
+    static constexpr int BITS = 6;
+    static constexpr int SLOTS = 1 << BITS;
+    static constexpr int LEVELS = 4;
+    // Past this many ticks in one go, rebuilding is cheaper than stepping
+    static constexpr qint64 MAX_STEPS = SLOTS * SLOTS;
+
+    struct Timer {
+        qint64 expires;
+        int bucket;
+    };
+
+    void place(quint64 id, qint64 expires);
+    void cascade(int level);
+
+    qint64 current;
+    QHash<quint64, Timer> timers;
+    QVector<QSet<quint64>> buckets;
+};
+
+#endif // TIMERWHEEL_H